@@ -72,7 +72,7 @@ function _awmsg
         set COMP_CWORD (count $COMP_WORDS)
     end
 
-    set literals -h --help -v --version exit spawn -c --continuous -1 --1-line -s --socket output list toplevels modes create destroy workspace list set toplevel list focused keyboard list device list current bind list run none maximize fullscreen previous next move resize pin toggle_floating up down left right close swap_up swap_down swap_left swap_right half_up half_down half_left half_right tile tile_sans auto_tile open window_to display rule list
+    set literals -h --help -v --version exit spawn -c --continuous -1 --1-line -s --socket output list toplevels modes create destroy workspace list set toplevel list focused keyboard list device list current bind list run none maximize fullscreen previous next move resize pin toggle_floating up down left right close swap_up swap_down swap_left swap_right half_up half_down half_left half_right tile tile_sans auto_tile open window_to display rule list notification list
 
     set descrs
     set descrs[1] "show help"
@@ -125,14 +125,15 @@ function _awmsg
     set descrs[48] "move the active window to workspace N"
     set descrs[49] "display key binding for name"
     set descrs[50] "list windowrules"
-    set descr_literal_ids 1 2 3 4 5 6 7 8 9 10 11 12 14 15 16 17 18 20 21 23 24 26 28 29 31 32 33 34 35 36 37 38 39 40 41 42 43 44 45 46 47 48 49 50 51 52 53 54 55 56 57 58 59 60 62
-    set descr_ids 1 1 2 2 3 4 5 5 6 6 7 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32 33 34 35 36 37 38 39 40 41 42 43 44 45 46 47 48 49 50
+    set descrs[51] "list recent notifications"
+    set descr_literal_ids 1 2 3 4 5 6 7 8 9 10 11 12 14 15 16 17 18 20 21 23 24 26 28 29 31 32 33 34 35 36 37 38 39 40 41 42 43 44 45 46 47 48 49 50 51 52 53 54 55 56 57 58 59 60 62 64
+    set descr_ids 1 1 2 2 3 4 5 5 6 6 7 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32 33 34 35 36 37 38 39 40 41 42 43 44 45 46 47 48 49 50 51
     set regexes 
     set literal_transitions_inputs
-    set literal_transitions_inputs[1] "1 2 3 4 5 6 7 8 9 10 11 12 13 19 22 25 27 30 61"
-    set literal_transitions_tos[1] "2 2 2 2 2 3 4 4 4 4 5 5 6 7 8 9 10 11 12"
-    set literal_transitions_inputs[4] "7 8 9 10 11 12 13 19 22 25 27 30 61"
-    set literal_transitions_tos[4] "4 4 4 4 5 5 6 7 8 9 10 11 12"
+    set literal_transitions_inputs[1] "1 2 3 4 5 6 7 8 9 10 11 12 13 19 22 25 27 30 61 63"
+    set literal_transitions_tos[1] "2 2 2 2 2 3 4 4 4 4 5 5 6 7 8 9 10 11 12 14"
+    set literal_transitions_inputs[4] "7 8 9 10 11 12 13 19 22 25 27 30 61 63"
+    set literal_transitions_tos[4] "4 4 4 4 5 5 6 7 8 9 10 11 12 14"
     set literal_transitions_inputs[6] "14 15 16 17 18"
     set literal_transitions_tos[6] "2 2 2 3 3"
     set literal_transitions_inputs[7] "20 21"
@@ -149,6 +150,8 @@ function _awmsg
     set literal_transitions_tos[12] 2
     set literal_transitions_inputs[13] "5 33 34 35 36 37 38 39 40 41 42 43 44 45 46 47 48 49 50 51 52 53 54 55 56 57 58 59"
     set literal_transitions_tos[13] "2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 2 3 3"
+    set literal_transitions_inputs[14] 64
+    set literal_transitions_tos[14] 2
 
     set star_transitions_from 3
     set star_transitions_to 2
@@ -181,8 +184,8 @@ function _awmsg
         return 1
     end
 
-    set literal_froms_level_0 10 1 4 9 11 12 6 13 8 7
-    set literal_inputs_level_0 "28 29|1 2 3 4 5 6 7 8 9 10 11 12 13 19 22 25 27 30 61|7 8 9 10 11 12 13 19 22 25 27 30 61|26|31 32 60|62|14 15 16 17 18|5 33 34 35 36 37 38 39 40 41 42 43 44 45 46 47 48 49 50 51 52 53 54 55 56 57 58 59|23 24|20 21"
+    set literal_froms_level_0 10 1 4 9 11 12 6 13 8 7 14
+    set literal_inputs_level_0 "28 29|1 2 3 4 5 6 7 8 9 10 11 12 13 19 22 25 27 30 61 63|7 8 9 10 11 12 13 19 22 25 27 30 61 63|26|31 32 60|62|14 15 16 17 18|5 33 34 35 36 37 38 39 40 41 42 43 44 45 46 47 48 49 50 51 52 53 54 55 56 57 58 59|23 24|20 21|64"
     set command_froms_level_0 5
     set commands_level_0 "0"
 
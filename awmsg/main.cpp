@@ -56,6 +56,8 @@ void print_usage() {
                  "\t\t- [r]un <name> <arg>\n"
                  "\t\t- [d]isplay <name>\n"
                  "\twindow[r]ule\n"
+                 "\t\t- [l]ist\n"
+                 "\t[n]otification\n"
                  "\t\t- [l]ist\n");
 }
 
@@ -239,6 +241,14 @@ int main(int argc, char **argv) {
             message = "r l";
             break;
         }
+        goto unknown;
+    case 'n': // notification
+        group = next(argc, argv);
+
+        if (group[0] == 'l') { // notification list
+            message = "n l";
+            break;
+        }
 
         [[fallthrough]];
     default:
@@ -0,0 +1,49 @@
+#include "../test.h"
+#include <chrono>
+
+// windows tiled by each retile
+constexpr uint32_t WINDOWS = 200;
+
+// retiles timed, alternating tile and tile_sans so every pass moves windows
+constexpr int ROUNDS = 50;
+
+// wall time of count awmsg commands in milliseconds
+static double time_commands(const std::string &a, const std::string &b,
+                            int count) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != count; ++i)
+        awmsg(i % 2 ? b : a);
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// time a 200 window retile, the IPC round trip is measured with a query
+// that does no layout work and subtracted
+int main() {
+    DEFAULT();
+
+    // footclient windows share one process, alacritty would need 200
+    exec0("foot --server");
+    sleep(1);
+    for (uint32_t i = 0; i != WINDOWS; ++i)
+        spawn("footclient -- sleep infinity");
+
+    // wait until every window is mapped
+    for (int i = 0; i != 60 && awmsg("t l").size() < WINDOWS; ++i)
+        sleep(1);
+    ASSERT(awmsg("t l").size() >= WINDOWS);
+
+    // settle the first layout before timing
+    AWMSG("b r tile");
+
+    const double retile = time_commands("b r tile_sans", "b r tile", ROUNDS);
+    const double baseline = time_commands("w l", "w l", ROUNDS);
+
+    std::cout << "retile of " << WINDOWS << " windows: "
+              << (retile - baseline) / ROUNDS << " ms ("
+              << retile / ROUNDS << " ms with IPC, " << baseline / ROUNDS
+              << " ms IPC alone)" << std::endl;
+
+    EXIT();
+}
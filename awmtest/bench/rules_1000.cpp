@@ -0,0 +1,172 @@
+#include "WindowRule.h"
+#include <chrono>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+// rules in the generated config
+constexpr uint32_t RULES = 1000;
+
+// windows matched against the rules per round
+constexpr uint32_t WINDOWS = 1000;
+
+constexpr int ROUNDS = 20;
+
+struct Window {
+    std::string app_id, title, tag;
+};
+
+// literal classes, literal prefixes, plain regexes and title rules, in the
+// proportions a large hand written config tends to have
+static std::vector<WindowRule *> generate_rules() {
+    std::vector<WindowRule *> rules;
+    for (uint32_t i = 0; i != RULES; ++i) {
+        const std::string n = std::to_string(i);
+        const uint32_t kind = i % 20;
+        if (kind < 12)
+            rules.push_back(
+                new WindowRule("", "app" + n, "", WINDOW_RULE_CLASS));
+        else if (kind < 16)
+            rules.push_back(new WindowRule("", "org\\.example\\.app" + n + ".*",
+                                           "", WINDOW_RULE_CLASS));
+        else if (kind < 19)
+            rules.push_back(new WindowRule("", "(tool|util)" + n + "[a-z]?",
+                                           "", WINDOW_RULE_CLASS));
+        else
+            rules.push_back(
+                new WindowRule("Window " + n, "", "", WINDOW_RULE_TITLE));
+    }
+    return rules;
+}
+
+// a mix of windows that hit each kind of rule and windows that hit none
+static std::vector<Window> generate_windows() {
+    std::vector<Window> windows;
+    for (uint32_t i = 0; i != WINDOWS; ++i) {
+        const std::string n = std::to_string(i);
+        switch (i % 5) {
+        case 0:
+            windows.push_back({"app" + n, "title", ""});
+            break;
+        case 1:
+            windows.push_back({"org.example.app" + n + ".Viewer", "title", ""});
+            break;
+        case 2:
+            windows.push_back({"util" + n + "x", "title", ""});
+            break;
+        case 3:
+            windows.push_back({"unmatched" + n, "Window " + n, ""});
+            break;
+        default:
+            windows.push_back({"unmatched" + n, "title", "tag"});
+            break;
+        }
+    }
+    return windows;
+}
+
+// how a rule was matched before patterns were split, every field a regex
+// run on a copy of the string
+struct RegexRule {
+    std::regex title, class_, tag;
+    uint8_t present;
+
+    explicit RegexRule(const WindowRule *rule)
+        : title(rule->title), class_(rule->class_), tag(rule->tag),
+          present(rule->matches_present) {}
+
+    bool matches(const Window &window) const {
+        bool match = true;
+        if (present & WINDOW_RULE_TITLE)
+            match &= std::regex_match(std::string(window.title), title);
+        if (present & WINDOW_RULE_CLASS)
+            match &= std::regex_match(std::string(window.app_id), class_);
+        if (present & WINDOW_RULE_TAG)
+            match &= std::regex_match(window.tag, tag);
+        return match;
+    }
+};
+
+static int32_t regex_scan(const std::vector<RegexRule> &rules,
+                          const Window &window) {
+    for (uint32_t i = 0; i != rules.size(); ++i)
+        if (rules[i].matches(window))
+            return i;
+    return -1;
+}
+
+// the same scan over the split patterns, without the index
+static int32_t linear_match(const std::vector<WindowRule *> &rules,
+                            const Window &window) {
+    for (uint32_t i = 0; i != rules.size(); ++i)
+        if (rules[i]->matches(window.app_id, window.title, window.tag))
+            return i;
+    return -1;
+}
+
+// time matching every window, the result is summed so it is not dropped
+template <typename F>
+static double time_rounds(const std::vector<Window> &windows, F match,
+                          int64_t &sum) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round != ROUNDS; ++round)
+        for (const Window &window : windows)
+            sum += match(window);
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+int main() {
+    const std::vector<WindowRule *> rules = generate_rules();
+    const std::vector<Window> windows = generate_windows();
+    const std::vector<RegexRule> regex_rules(rules.begin(), rules.end());
+
+    WindowRuleIndex index;
+    const auto start = std::chrono::steady_clock::now();
+    index.compile(rules);
+    const double compile = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+
+    // the index has to pick the same rule as both scans
+    for (const Window &window : windows) {
+        const int32_t expected = regex_scan(regex_rules, window);
+        if (linear_match(rules, window) != expected ||
+            index.match_index(window.app_id, window.title, window.tag) !=
+                expected) {
+            std::cerr << "index and scan disagree for " << window.app_id
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    int64_t regex_sum = 0, linear_sum = 0, index_sum = 0;
+    const double regex = time_rounds(
+        windows, [&](const Window &w) { return regex_scan(regex_rules, w); },
+        regex_sum);
+    const double linear = time_rounds(
+        windows, [&](const Window &w) { return linear_match(rules, w); },
+        linear_sum);
+    const double indexed = time_rounds(
+        windows,
+        [&](const Window &w) {
+            return index.match_index(w.app_id, w.title, w.tag);
+        },
+        index_sum);
+
+    const double maps = static_cast<double>(WINDOWS) * ROUNDS;
+    std::cout << RULES << " rules compiled in " << compile << " ms"
+              << std::endl;
+    std::cout << "regex scan: " << regex / maps << " us per map" << std::endl;
+    std::cout << "pattern scan: " << linear / maps << " us per map ("
+              << regex / linear << "x)" << std::endl;
+    std::cout << "index: " << indexed / maps << " us per map ("
+              << regex / indexed << "x)" << std::endl;
+
+    for (WindowRule *rule : rules)
+        delete rule;
+
+    return regex_sum == linear_sum && linear_sum == index_sum ? 0 : 1;
+}
@@ -6,7 +6,7 @@
 struct Toplevel;
 
 struct ActivationToken {
-    pid_t pid;
+    pid_t pid{0};
 
     wlr_xdg_activation_token_v1 *token;
     wl_listener destroy;
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "wlr.h"
-#include <memory>
+#include <deque>
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
 struct Toplevel;
@@ -11,8 +13,8 @@ enum class SplitType { NONE, HORIZONTAL, VERTICAL };
 
 struct BSPNode {
     BSPNode *parent{nullptr};
-    std::unique_ptr<BSPNode> first_child{nullptr};
-    std::unique_ptr<BSPNode> second_child{nullptr};
+    BSPNode *first_child{nullptr};
+    BSPNode *second_child{nullptr};
 
     SplitType split{SplitType::NONE};
     float ratio{0.5f};
@@ -20,21 +22,40 @@ struct BSPNode {
     Toplevel *toplevel{nullptr};
     wlr_box geometry{};
 
+    // number of leaves holding a toplevel in this subtree
+    int leaves{0};
+
+    // layout of this node must be recalculated
+    bool dirty{true};
+    // some descendant is dirty
+    bool child_dirty{false};
+    // this leaf, or some leaf below, may need its geometry applied
+    bool needs_apply{false};
+
     BSPNode() = default;
-    explicit BSPNode(Toplevel *tl) : toplevel(tl) {}
+    explicit BSPNode(Toplevel *tl) : toplevel(tl), leaves(tl ? 1 : 0) {}
 
     bool is_leaf() const { return split == SplitType::NONE; }
     bool is_container() const { return !is_leaf(); }
 
-    BSPNode *find_toplevel(Toplevel *tl);
-    bool remove_toplevel(Toplevel *tl);
     void get_toplevels(std::vector<Toplevel *> &toplevels) const;
-    int count_leaves() const;
+    int count_leaves() const { return leaves; }
     BSPNode *find_insertion_point();
+    void mark_dirty();
+    void update_leaves();
+};
+
+// shape of a tree without its toplevels, leaves refer to toplevels by an id
+// chosen by the caller
+struct BSPShape {
+    SplitType split{SplitType::NONE};
+    float ratio{0.5f};
+    int leaf{-1};
+    std::vector<BSPShape> children;
 };
 
 struct BSPTree {
-    std::unique_ptr<BSPNode> root{nullptr};
+    BSPNode *root{nullptr};
     Workspace *workspace{nullptr};
 
     explicit BSPTree(Workspace *ws) : workspace(ws) {}
@@ -44,6 +65,7 @@ struct BSPTree {
     void remove(Toplevel *toplevel);
     void apply_layout(const wlr_box &bounds, bool use_transaction = true);
     BSPNode *find_node(Toplevel *toplevel);
+    void check_leaf(Toplevel *toplevel);
     bool get_toplevel_geometry(Toplevel *toplevel, const wlr_box &bounds,
                                wlr_box &out_geometry);
     void adjust_ratio(BSPNode *node, float new_ratio);
@@ -52,14 +74,32 @@ struct BSPTree {
     void rebuild_grid(std::vector<Toplevel *> toplevels);
     void rebuild_dwindle(std::vector<Toplevel *> toplevels);
     void insert_at_dwindle(Toplevel *toplevel, Toplevel *target);
+    bool swap(Toplevel *a, Toplevel *b);
     void clear();
 
+    BSPShape save(const std::function<int(Toplevel *)> &id) const;
+    void restore(const BSPShape &shape,
+                 const std::function<Toplevel *(int)> &lookup);
+
     void handle_interactive_resize(Toplevel *toplevel, uint32_t edges,
                                    int cursor_x, int cursor_y,
                                    const wlr_box &bounds);
 
   private:
-    void calculate_layout(BSPNode *node, const wlr_box &bounds);
+    // nodes are allocated from a pool, freed nodes are reused
+    std::deque<BSPNode> pool;
+    std::vector<BSPNode *> free_nodes;
+
+    // leaf holding each toplevel
+    std::unordered_map<Toplevel *, BSPNode *> leaf_nodes;
+
+    BSPNode *alloc_node(Toplevel *toplevel = nullptr);
+    void free_node(BSPNode *node);
+    BSPNode *build(const BSPShape &shape,
+                   const std::function<Toplevel *(int)> &lookup);
+    void set_leaf(BSPNode *node, Toplevel *toplevel);
+    void split_leaf(BSPNode *leaf, Toplevel *toplevel, SplitType split);
+    bool calculate_layout(BSPNode *node, const wlr_box &bounds);
     void apply_geometries(BSPNode *node, bool immediate = false);
     void dump_tree(BSPNode *node, int depth);
     SplitType determine_split_type(BSPNode *node);
@@ -1,9 +1,9 @@
 #pragma once
 
-#include "Toml.h"
 #include "WindowRule.h"
 #include "wlr.h"
-#include <filesystem>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 const std::string MODIFIERS[] = {
@@ -64,6 +64,13 @@ struct Bind {
     }
 };
 
+// what a key or button press resolves to in the compiled bind table
+struct BindAction {
+    BindName name{BIND_NONE};
+    int n{1};            // workspace number of digit binds
+    int32_t command{-1}; // index into commands of user-defined binds
+};
+
 enum RenderBitDepth {
     RENDER_BIT_DEPTH_DEFAULT,
     RENDER_BIT_DEPTH_6,
@@ -106,14 +113,38 @@ struct OutputConfig {
         scale = config_head->state.scale;
         adaptive_sync = config_head->state.adaptive_sync_enabled;
     }
+
+    bool operator==(const OutputConfig &other) const {
+        return name == other.name && enabled == other.enabled &&
+               width == other.width && height == other.height &&
+               x == other.x && y == other.y && refresh == other.refresh &&
+               transform == other.transform && scale == other.scale &&
+               adaptive_sync == other.adaptive_sync &&
+               allow_tearing == other.allow_tearing && hdr == other.hdr &&
+               render_bit_depth == other.render_bit_depth &&
+               max_render_time == other.max_render_time;
+    }
 };
 
 enum TileMethod { TILE_NONE, TILE_GRID, TILE_MASTER, TILE_DWINDLE, TILE_BSP };
 enum FocusOnWindowActivation { FOWA_NONE, FOWA_ACTIVE, FOWA_ANY };
 
+// sections of the config that are re-applied independently on reload
+enum ConfigSection {
+    CONFIG_KEYBOARD = 1 << 0,
+    CONFIG_POINTER = 1 << 1,
+    CONFIG_XCURSOR = 1 << 2,
+    CONFIG_OUTPUTS = 1 << 3,
+    CONFIG_BINDS = 1 << 4,
+    CONFIG_RULES = 1 << 5,
+    CONFIG_TILING = 1 << 6,
+    CONFIG_GENERAL = 1 << 7,
+};
+
 struct Config {
     std::string path;
-    std::filesystem::file_time_type last_write_time;
+    std::string source; // text of the file the config was parsed from
+    bool loaded{false}; // the file at path was parsed
 
     std::vector<std::pair<std::string, std::string>> startup_env;
     std::vector<std::string> startup_commands;
@@ -147,6 +178,7 @@ struct Config {
             double accel_speed{0.0};
             bool natural_scroll{false};
             bool left_handed{false};
+            bool batch_motion{true};
         } mouse;
 
         struct {
@@ -171,6 +203,7 @@ struct Config {
             libinput_config_accel_profile profile{
                 LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE};
             double accel_speed{0.0};
+            bool batch_motion{true};
         } touchpad;
     } cursor;
 
@@ -194,18 +227,25 @@ struct Config {
     // compostior binds
     std::vector<Bind> binds;
 
+    // binds and commands by modifiers and keysym, number binds are expanded
+    // to one entry per digit
+    std::unordered_map<uint64_t, BindAction> bind_table;
+
     // outputs
     std::vector<OutputConfig *> outputs;
 
     // window rules
     std::vector<WindowRule *> window_rules;
+    WindowRuleIndex rule_index;
 
     Config();
     explicit Config(const std::string &path);
+    Config(const std::string &path, std::string source);
     ~Config();
 
-    void set_bind(const std::string &name, const toml::Table *source,
-                  const BindName target);
+    static bool read(const std::string &path, std::string &source);
     bool load();
-    void update(const struct Server *server);
+    void compile_binds();
+    const BindAction *find_bind(uint32_t modifiers, xkb_keysym_t sym) const;
+    uint32_t diff(const Config &other) const;
 };
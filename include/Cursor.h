@@ -2,6 +2,7 @@
 
 #include "wlr.h"
 #include <map>
+#include <unordered_set>
 #include <vector>
 
 enum CursorMode {
@@ -27,6 +28,29 @@ struct ResizeNeighbor {
     bool adjacent_top{false};
 };
 
+enum HitType {
+    HIT_NONE,
+    HIT_TOPLEVEL,
+    HIT_LAYER_SURFACE,
+    HIT_DECORATION,
+    HIT_LOCK_SURFACE,
+};
+
+// classified result of a scene hit test
+struct Hit {
+    HitType type{HIT_NONE};
+    wlr_scene_node *node{nullptr};
+    wlr_surface *surface{nullptr};
+    double sx{0}, sy{0};
+
+    // surface belongs to a popup of the toplevel or layer surface
+    bool popup{false};
+
+    struct Toplevel *toplevel{nullptr};
+    struct LayerSurface *layer_surface{nullptr};
+    struct Decoration *decoration{nullptr};
+};
+
 struct Cursor {
     struct Server *server;
     wlr_cursor *cursor;
@@ -36,6 +60,19 @@ struct Cursor {
 
     std::vector<wlr_pointer *> pointers;
 
+    // pointers whose cursor motion is settled once per event loop wakeup
+    std::unordered_set<wlr_input_device *> batched_pointers;
+    wl_event_source *motion_idle{nullptr};
+    uint32_t pending_motion_time{0};
+
+    // last surface hit and the layout region where it stays the hit, valid
+    // until the scene is rendered again or geometry changes
+    Hit last_hit;
+    pixman_region32_t last_hit_region;
+    double last_hit_x{0}, last_hit_y{0}; // layout position of the surface
+    uint64_t last_hit_serial{0};
+    wl_listener last_hit_destroy;
+
     double grab_x, grab_y;
     wlr_box grab_geobox;
     wlr_box resize_original_geo;
@@ -84,6 +121,10 @@ struct Cursor {
     void notify_activity();
     void process_motion(uint32_t time, wlr_input_device *device, double dx,
                         double dy, double unaccel_dx, double unaccel_dy);
+    void process_cursor_motion(uint32_t time);
+    void flush_motion();
+    Hit hit_at_cursor();
+    void invalidate_hit();
     void process_move();
     void process_resize();
     void update_swap_indicator();
@@ -95,4 +136,6 @@ struct Cursor {
     bool is_touchpad(wlr_pointer *pointer) const;
     void set_config(wlr_pointer *pointer);
     void reconfigure_all();
+    wlr_xcursor_manager *create_xcursor_manager() const;
+    void reload_xcursor();
 };
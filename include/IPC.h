@@ -30,7 +30,8 @@ enum IPCMessage {
     IPC_BIND_LIST,
     IPC_BIND_RUN,
     IPC_BIND_DISPLAY,
-    IPC_RULE_LIST
+    IPC_RULE_LIST,
+    IPC_NOTIFICATION_LIST
 };
 
 struct IPC {
@@ -42,7 +43,8 @@ struct IPC {
 
     IPC(Server *server, std::string sock_path);
 
-    json handle_command(const IPCMessage message, const std::string &data);
+    json handle_command(const IPCMessage message, const std::string &data,
+                        const int client_fd = -1);
 
     std::map<int, std::vector<std::pair<IPCMessage, std::string>>>
         subscriptions;
@@ -53,5 +55,11 @@ struct IPC {
     void notify_clients(const IPCMessage message);
     void notify_clients(const std::vector<IPCMessage> &messages);
 
+    // messages queued to be sent once the event loop is idle
+    uint32_t pending_messages{0};
+    wl_event_source *pending_messages_idle{nullptr};
+
+    void notify_clients_later(const std::vector<IPCMessage> &messages);
+
     void stop();
 };
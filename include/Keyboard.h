@@ -15,6 +15,7 @@ struct Keyboard {
     ~Keyboard();
 
     void update_config() const;
+    void set_keymap(xkb_keymap *keymap) const;
     uint32_t keysyms_raw(xkb_keycode_t keycode,
                          const xkb_keysym_t **keysyms) const;
     uint32_t keysyms_translated(xkb_keycode_t keycode,
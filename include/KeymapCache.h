@@ -0,0 +1,58 @@
+#pragma once
+
+#include "wlr.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// a keymap compiled by the worker thread
+struct KeymapJob {
+    std::string key;
+    std::string model, layout, variant, options;
+    xkb_keymap *keymap{nullptr};
+    bool failed{false};
+};
+
+// compiled keymaps by rmlvo names, shared by every keyboard and kept across
+// config reloads. new names are compiled on a worker thread while keyboards
+// keep their current keymap
+struct KeymapCache {
+    struct Server *server;
+    xkb_context *context;
+    std::unordered_map<std::string, xkb_keymap *> keymaps;
+
+    // keymap last handed out and the names keyboards should end up with
+    xkb_keymap *current{nullptr};
+    std::string wanted;
+
+    // names queued or being compiled
+    std::unordered_set<std::string> compiling;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<KeymapJob *> queue;
+    std::vector<KeymapJob *> done;
+    bool stopping{false};
+
+    // wakes the event loop when a job is done
+    int done_fd{-1};
+    wl_event_source *done_source{nullptr};
+
+    explicit KeymapCache(Server *server);
+    ~KeymapCache();
+
+    xkb_keymap *get(const xkb_rule_names &names);
+
+  private:
+    void set_current(xkb_keymap *keymap);
+    void insert(std::string key, xkb_keymap *keymap);
+    void compile_async(std::string key, const xkb_rule_names &names);
+    void run_worker();
+    void finish_jobs();
+};
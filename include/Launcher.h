@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// how a process is started, env entries override the compositor's own
+struct LaunchOptions {
+    std::vector<std::pair<std::string, std::string>> env;
+    std::string cwd;
+    int stdin_fd{-1}; // becomes the child's stdin
+    bool activation_token{false};
+};
+
+// start argv[0] from PATH with posix_spawn, the compositor is not copied
+// for the child. returns the pid or -1
+pid_t spawn_process(const std::vector<std::string> &argv,
+                    const LaunchOptions &options = {});
+
+// starts commands for the compositor and reaps them when they exit
+struct Launcher {
+    struct Server *server;
+
+    // running children by pid, with the command they were started for
+    std::unordered_map<pid_t, std::string> children;
+
+    explicit Launcher(Server *server);
+
+    pid_t spawn(const std::string &command, const LaunchOptions &options = {});
+    void reap();
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Config.h"
+#include "wlr.h"
+#include <cstddef>
+#include <cstdint>
+
+// a window as seen by the layout engine
+struct LayoutWindow {
+    wlr_box geometry; // current geometry, used for ordering
+    uint32_t index;   // slot in the output span
+};
+
+// view over caller owned memory
+template <typename T> struct LayoutSpan {
+    T *data{nullptr};
+    size_t size{0};
+
+    T &operator[](size_t i) const { return data[i]; }
+    T *begin() const { return data; }
+    T *end() const { return data + size; }
+};
+
+namespace layout {
+
+// arrange windows within area, writing the box of each window to
+// out[window.index]. windows may be reordered, nothing is allocated.
+template <TileMethod method>
+void arrange(LayoutSpan<LayoutWindow> windows, const wlr_box &area,
+             LayoutSpan<wlr_box> out);
+
+template <>
+void arrange<TILE_GRID>(LayoutSpan<LayoutWindow> windows, const wlr_box &area,
+                        LayoutSpan<wlr_box> out);
+template <>
+void arrange<TILE_MASTER>(LayoutSpan<LayoutWindow> windows,
+                          const wlr_box &area, LayoutSpan<wlr_box> out);
+template <>
+void arrange<TILE_DWINDLE>(LayoutSpan<LayoutWindow> windows,
+                           const wlr_box &area, LayoutSpan<wlr_box> out);
+template <>
+void arrange<TILE_BSP>(LayoutSpan<LayoutWindow> windows, const wlr_box &area,
+                       LayoutSpan<wlr_box> out);
+
+// dispatch on a runtime method, returns false if the method does not tile
+bool arrange(TileMethod method, LayoutSpan<LayoutWindow> windows,
+             const wlr_box &area, LayoutSpan<wlr_box> out);
+
+} // namespace layout
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "BSPTree.h"
+#include "wlr.h"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// a window as it was laid out when the snapshot was taken
+struct SavedWindow {
+    std::string app_id, title, tag;
+    std::string output;
+    uint32_t workspace{0};
+    wlr_box geometry{};
+    bool floating{false};
+
+    // toplevel that has been restored into this slot
+    struct Toplevel *toplevel{nullptr};
+};
+
+struct SavedWorkspace {
+    std::string output;
+    uint32_t num{0};
+    bool auto_tile{false};
+    BSPShape tree;
+};
+
+// snapshot of workspaces, bsp trees and window geometry kept across restarts
+struct LayoutState {
+    struct Server *server;
+    std::string path;
+    wl_event_source *save_timer{nullptr};
+
+    // contents of the last write, used to skip redundant writes
+    std::string last_saved;
+
+    std::vector<SavedWindow> windows;
+    std::vector<SavedWorkspace> workspaces;
+    std::unordered_map<std::string, uint32_t> active_workspaces;
+
+    // unmatched windows by app_id, title and tag, and by app_id alone
+    std::unordered_map<std::string, std::vector<uint32_t>> by_key;
+    std::unordered_map<std::string, std::vector<uint32_t>> by_app_id;
+
+    // number of save timer ticks left before unmatched windows are dropped
+    uint32_t restore_ticks;
+
+    explicit LayoutState(Server *server);
+    ~LayoutState();
+
+    void load();
+    void save();
+
+    SavedWindow *match(Toplevel *toplevel);
+    Workspace *workspace_for(const SavedWindow *saved) const;
+    void restore(Toplevel *toplevel, SavedWindow *saved,
+                 struct Workspace *workspace);
+    void release(Toplevel *toplevel);
+    void restore_output(struct Output *output);
+
+  private:
+    const SavedWorkspace *saved_workspace(const std::string &output,
+                                          uint32_t num) const;
+    void forget();
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+#include <wayland-server-core.h>
+
+// hand a notification to the notifier, safe to call from any thread and
+// before the notifier exists
+void queue_notification(std::string title, std::string message);
+
+struct Notification {
+    uint32_t id;
+    std::string title, message;
+    uint32_t count{1}; // identical messages merged into this one
+    std::time_t time;  // last time it was posted
+    int64_t posted_ms; // same on the monotonic clock
+};
+
+// collects notifications on the event loop. identical messages are merged,
+// bursts are sent as one notification per title, and they reach the
+// desktop through a single helper process instead of a shell each
+struct Notifier {
+    struct Server *server;
+
+    // the last notifications, oldest first, for IPC
+    std::deque<Notification> recent;
+    uint32_t next_id{1};
+
+    // messages waiting for the batch timer, and when each was last sent
+    std::vector<Notification> batch;
+    std::unordered_map<std::string, int64_t> last_sent;
+
+    int wake_fd{-1};
+    wl_event_source *wake_source{nullptr};
+    wl_event_source *batch_timer{nullptr};
+
+    // sh loop running notify-send, fed over a socket
+    pid_t helper{-1};
+    int helper_fd{-1};
+
+    explicit Notifier(Server *server);
+    ~Notifier();
+
+    void post(const std::string &title, const std::string &message);
+    void flush();
+
+  private:
+    void drain();
+    bool start_helper();
+    void stop_helper();
+};
@@ -2,6 +2,7 @@
 
 #include "Workspace.h"
 #include "wlr.h"
+#include <vector>
 
 struct Output {
     wl_list link;
@@ -38,6 +39,10 @@ struct Output {
     bool allow_tearing{false};
     bool enabled{true};
 
+    // workspaces of this output indexed by number, unused numbers are null
+    std::vector<Workspace *> workspaces;
+    uint32_t active_workspace{0};
+
     Output(Server *server, struct wlr_output *wlr_output);
     ~Output();
 
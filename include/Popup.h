@@ -10,6 +10,8 @@ struct Popup {
     wlr_scene_tree *image_capture_tree;
 
     wl_listener commit;
+    wl_listener map;
+    wl_listener unmap;
     wl_listener reposition;
     wl_listener new_popup;
     wl_listener destroy;
@@ -9,6 +9,8 @@
 #include "Config.h"
 #include "IPC.h"
 #include "LayerSurface.h"
+#include "Launcher.h"
+#include "Notifier.h"
 #include "Output.h"
 #include "OutputManager.h"
 #include "PointerConstraint.h"
@@ -47,6 +49,7 @@ struct Server {
     Cursor *cursor;
     Seat *seat;
     wl_list keyboards;
+    struct KeymapCache *keymap_cache;
 
     wlr_pointer_constraints_v1 *wlr_pointer_constraints;
     wl_listener new_pointer_constraint;
@@ -54,6 +57,13 @@ struct Server {
     OutputManager *output_manager;
     WorkspaceManager *workspace_manager;
     TransactionManager *transaction_manager;
+    struct LayoutState *layout_state{nullptr};
+    Launcher *launcher;
+    Notifier *notifier{nullptr};
+
+    // bumped whenever toplevel geometry or workspace membership changes on
+    // any workspace, workspaces keep their own serial as well
+    uint64_t geometry_serial{1};
 
     struct {
         wlr_scene_tree *background;
@@ -133,7 +143,13 @@ struct Server {
 #endif
 
     wl_event_source *signal_handler{nullptr};
-    wl_event_source *config_update_timer{nullptr};
+
+    // config file watch, reloads are debounced by config_reload_timer
+    int config_watch_fd{-1};
+    int config_watch_file{-1};
+    std::string config_watch_name;
+    wl_event_source *config_watch{nullptr};
+    wl_event_source *config_reload_timer{nullptr};
 
     IPC *ipc{nullptr};
 
@@ -144,7 +160,12 @@ struct Server {
 
     void exit();
 
-    void spawn(const std::string &command) const;
+    pid_t spawn(const std::string &command,
+                const LaunchOptions &options = {}) const;
+
+    void watch_config();
+    void watch_config_file();
+    void reload_config();
 
     Output *get_output(const wlr_output *wlr_output) const;
     Workspace *get_workspace(Toplevel *toplevel) const;
@@ -152,13 +173,7 @@ struct Server {
 
     Output *focused_output() const;
 
-    template <typename T>
-    T *surface_at(double lx, double ly, wlr_surface **surface, double *sx,
-                  double *sy);
-    Toplevel *toplevel_at(double lx, double ly, wlr_surface **surface,
-                          double *sx, double *sy);
-    LayerSurface *layer_surface_at(double lx, double ly, wlr_surface **surface,
-                                   double *sx, double *sy);
+    Hit hit_test(double lx, double ly) const;
 
     bool handle_bind(Bind bind);
     void update_idle_inhibitors(wlr_surface *sans);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "wlr.h"
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// a toplevel edge in a sorted edge list
+struct SpatialEntry {
+    int edge;
+    uint32_t order; // position in the workspace toplevel list
+    wlr_box box;    // geometry when the index was built
+    struct Toplevel *toplevel;
+};
+
+// sorted edge lists over the toplevels of a workspace, rebuilt lazily
+// whenever the workspace geometry serial moves on
+struct SpatialIndex {
+    std::vector<SpatialEntry> left, right, top, bottom;
+    uint64_t serial{0};
+
+    // rebuild from a workspace toplevel list if serial is out of date
+    void update(wl_list *toplevels, uint64_t serial);
+
+    // entries of list with edge in [min, max]
+    static std::pair<const SpatialEntry *, const SpatialEntry *>
+    range(const std::vector<SpatialEntry> &list, int min, int max);
+
+    // nearest toplevel past from in the given direction, ties on the edge
+    // are broken by the smallest distance on the other axis
+    Toplevel *nearest(const wlr_box &from, wlr_direction direction) const;
+
+    // first toplevel in list order containing the point that passes filter
+    template <typename Filter>
+    Toplevel *at(int x, int y, Filter &&filter) const;
+
+    // append toplevels with an edge within threshold of an edge of box,
+    // each toplevel is appended at most once
+    void adjacent(const wlr_box &box, int threshold,
+                  std::vector<Toplevel *> &out) const;
+};
+
+template <typename Filter>
+Toplevel *SpatialIndex::at(int x, int y, Filter &&filter) const {
+    constexpr int min = std::numeric_limits<int>::min();
+    constexpr int max = std::numeric_limits<int>::max();
+
+    // scan the smallest of the four half planes that must contain a hit
+    auto candidates = range(left, min, x);
+    auto try_range = [&](auto r) {
+        if (r.second - r.first < candidates.second - candidates.first)
+            candidates = r;
+    };
+    try_range(range(right, x + 1, max));
+    try_range(range(top, min, y));
+    try_range(range(bottom, y + 1, max));
+
+    const SpatialEntry *best = nullptr;
+    for (const SpatialEntry *e = candidates.first; e != candidates.second;
+         ++e) {
+        if (best && e->order > best->order)
+            continue;
+
+        const wlr_box &geo = e->box;
+        if (x >= geo.x && x < geo.x + geo.width && y >= geo.y &&
+            y < geo.y + geo.height && filter(e->toplevel))
+            best = e;
+    }
+
+    return best ? best->toplevel : nullptr;
+}
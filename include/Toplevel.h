@@ -10,6 +10,8 @@
 struct Toplevel {
     wl_list link;
     struct Server *server;
+    // workspace whose toplevel list link is in
+    struct Workspace *workspace{nullptr};
     wlr_scene_tree *scene_tree{nullptr};
     wlr_scene_surface *scene_surface{nullptr};
 
@@ -46,17 +48,18 @@ struct Toplevel {
     wl_listener xwayland_close;
 #endif
 
-    wlr_foreign_toplevel_handle_v1 *foreign_handle;
+    wlr_foreign_toplevel_handle_v1 *foreign_handle{nullptr};
     wl_listener foreign_activate;
     wl_listener foreign_close;
 
-    wlr_ext_foreign_toplevel_handle_v1 *ext_foreign_handle;
+    wlr_ext_foreign_toplevel_handle_v1 *ext_foreign_handle{nullptr};
     wl_listener ext_foreign_destroy;
 
     wlr_xdg_dialog_v1 *wlr_xdg_dialog{nullptr};
     wl_listener xdg_dialog_destroy;
 
     bool hidden{false};
+    bool suspended{false}; // last suspended state sent to the client
     bool pinned{false};
     bool scene_hidden_for_autotile{false};
     bool is_floating{false};
@@ -84,8 +87,18 @@ struct Toplevel {
     bool in_transaction{false};
     wlr_box pending_transaction_geometry{};
 
+    // transaction this toplevel has a pending change in, and its index
+    struct Transaction *transaction{nullptr};
+    uint32_t transaction_slot{0};
+
     std::string tag{};
 
+    // index of the window rule matched at the last check, -1 for none, and
+    // the fields that changed since, checked together when the timer fires
+    int32_t rule{-1};
+    uint8_t rule_fields{0}; // WindowRuleFlags
+    wl_event_source *rule_timer{nullptr};
+
     Toplevel(Server *server, wlr_xdg_toplevel *wlr_xdg_toplevel);
     ~Toplevel();
 
@@ -105,6 +118,9 @@ struct Toplevel {
     std::string_view get_app_id() const;
     void update_title();
     void update_app_id();
+    void update_tag(const char *tag);
+    void rule_field_changed(uint8_t field);
+    void check_rules();
 
     void update_pid();
     void set_token(ActivationToken *token);
@@ -115,10 +131,15 @@ struct Toplevel {
     void set_position_size(const wlr_box &geometry);
     void set_decoration_mode(wlr_xdg_toplevel_decoration_v1_mode mode);
     wlr_box get_geometry();
+    wlr_box target_geometry() const;
+    void set_geometry(const wlr_box &box);
     void set_hidden(bool hidden);
+    void set_suspended(bool suspended);
+    wlr_scene_tree *layer_tree() const;
     bool fullscreen() const;
     bool surface_fullscreen() const;
     bool maximized() const;
+    bool requested_maximized() const;
     void set_fullscreen(bool fullscreen);
     void set_maximized(bool maximized);
     void toggle_fullscreen();
@@ -2,7 +2,6 @@
 
 #include "wlr.h"
 #include <vector>
-#include <unordered_set>
 
 struct PendingGeometry {
     struct Toplevel *toplevel;
@@ -14,7 +13,7 @@ struct PendingGeometry {
 struct Transaction {
     struct Server *server;
     std::vector<PendingGeometry> pending_changes;
-    std::unordered_set<struct Toplevel *> waiting_for_commit;
+    uint32_t waiting_for_commit{0};
     wl_event_source *timeout_timer{nullptr};
     bool committed{false};
 
@@ -42,9 +41,13 @@ struct Transaction {
     // Remove a toplevel from this transaction (e.g., when it unmaps)
     void remove_toplevel(Toplevel *toplevel);
 
+    // Clear all state so the transaction can be reused
+    void reset();
+
 private:
     void setup_timeout();
     void cleanup();
+    void finish();
     static int on_timeout(void *data);
 };
 
@@ -53,10 +56,17 @@ struct TransactionManager {
     Server *server;
     Transaction *active_transaction{nullptr};
 
+    // number of nested begin calls on the open transaction
+    uint32_t depth{0};
+
+    // finished transactions kept for reuse
+    std::vector<Transaction *> pool;
+
     explicit TransactionManager(Server *server);
     ~TransactionManager();
 
-    // Start a new transaction (commits any existing one first)
+    // Start a new transaction (commits any committed one first), nested calls
+    // join the transaction that is still open
     Transaction *begin();
 
     // Get the current active transaction, or nullptr if none
@@ -70,4 +80,7 @@ struct TransactionManager {
     
     // Remove a toplevel from any active transaction
     void remove_toplevel(Toplevel *toplevel);
+
+    // Return a finished transaction to the pool
+    void release(Transaction *txn);
 };
@@ -3,6 +3,9 @@
 #include "wlr.h"
 #include <regex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 enum WindowRuleFlags {
     WINDOW_RULE_TITLE = 1 << 0,
@@ -29,10 +32,23 @@ enum TilingMode {
 };
 
 struct Toplevel;
+struct Workspace;
+
+// a rule pattern, literals and literal prefixes are compared before the
+// regex is run, or instead of it
+struct RulePattern {
+    enum Kind { LITERAL, PREFIX, REGEX } kind;
+    std::string literal; // whole pattern or its literal prefix
+    std::regex re;       // unset for literals
+
+    explicit RulePattern(const std::string &pattern);
+
+    bool matches(std::string_view subject) const;
+};
 
 struct WindowRule {
-    std::string title, class_, tag;        // uncompiled
-    std::regex title_re, class_re, tag_re; // compiled
+    std::string title, class_, tag;                       // uncompiled
+    RulePattern title_pattern, class_pattern, tag_pattern; // compiled
     uint8_t matches_present;               // WindowRuleFlags
 
     int workspace{0};
@@ -47,6 +63,49 @@ struct WindowRule {
                std::string tag_match, uint8_t matches_present);
     ~WindowRule();
 
-    bool matches(Toplevel *toplevel);
+    bool operator==(const WindowRule &other) const;
+    bool matches(Toplevel *toplevel) const;
+    bool matches(std::string_view app_id, std::string_view title,
+                 std::string_view tag) const;
+    bool floats(Toplevel *toplevel) const;
+    bool skips_auto_tile(bool floating) const;
+    void set_state(Toplevel *toplevel) const;
     void apply(Toplevel *toplevel);
+    void reapply(Toplevel *toplevel, Workspace *current);
+};
+
+// the rules of a config indexed by their class pattern, only rules that
+// can match an app_id are checked in full
+struct WindowRuleIndex {
+    std::vector<WindowRule *> rules; // owned by the config
+
+    // rule indices by literal class
+    std::unordered_map<std::string, std::vector<uint32_t>> by_class;
+
+    // rules whose class starts with a literal prefix
+    std::vector<std::pair<std::string, uint32_t>> by_prefix;
+
+    // rules whose class is any other regex, combined tells if one of them
+    // can match at all
+    std::vector<uint32_t> by_regex;
+    std::regex combined;
+    bool has_combined{false};
+
+    // rules without a class
+    std::vector<uint32_t> any_class;
+
+    // rules that look at the title or tag, and the fields any rule looks at
+    std::vector<uint32_t> with_title;
+    std::vector<uint32_t> with_tag;
+    uint8_t fields{0}; // WindowRuleFlags
+
+    void compile(const std::vector<WindowRule *> &window_rules);
+    void class_candidates(std::string_view app_id,
+                          std::vector<uint32_t> &candidates) const;
+    int32_t match_index(Toplevel *toplevel) const;
+    int32_t match_index(std::string_view app_id, std::string_view title,
+                        std::string_view tag) const;
+    WindowRule *match(Toplevel *toplevel) const;
+    int32_t recheck(Toplevel *toplevel, int32_t previous,
+                    uint8_t changed) const;
 };
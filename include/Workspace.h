@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Layout.h"
+#include "SpatialIndex.h"
 #include "wlr.h"
 #include <memory>
 #include <vector>
@@ -14,7 +16,32 @@ struct Workspace {
     struct Toplevel *active_toplevel{nullptr};
     bool auto_tile{false};
     std::unique_ptr<BSPTree> bsp_tree{nullptr};
-    wl_event_source *pending_layout_idle{nullptr};
+
+    // scene subtrees holding the toplevels of this workspace, disabled as a
+    // whole while the workspace is hidden
+    struct {
+        wlr_scene_tree *floating;
+        wlr_scene_tree *fullscreen;
+    } layers;
+    bool hidden{true};
+    // layout and visibility updates are deferred until the event loop is idle
+    bool needs_layout{false};
+    bool needs_visibility{false};
+
+    // scratch buffers reused by tile()
+    std::vector<Toplevel *> layout_toplevels;
+    std::vector<LayoutWindow> layout_windows;
+    std::vector<wlr_box> layout_boxes;
+
+    // key of the result held in layout_boxes
+    TileMethod layout_cache_method{TILE_NONE};
+    wlr_box layout_cache_area{};
+    std::vector<Toplevel *> layout_cache_toplevels;
+
+    // edge lists for directional and point queries, rebuilt when the serial
+    // moves on
+    mutable SpatialIndex spatial_index;
+    uint64_t geometry_serial{1};
 
     Workspace(Output *output, uint32_t num);
     ~Workspace();
@@ -28,7 +55,9 @@ struct Workspace {
     void swap(Toplevel *a, Toplevel *b);
     void swap(Toplevel *other);
     Toplevel *in_direction(wlr_direction direction) const;
-    void set_hidden(bool hidden) const;
+    const SpatialIndex &spatial() const;
+    void geometry_changed();
+    void set_hidden(bool hidden);
     void set_half_in_direction(Toplevel *toplevel, wlr_direction direction);
     void focus();
     void focus_toplevel(Toplevel *toplevel);
@@ -38,6 +67,11 @@ struct Workspace {
     void tile();
     void tile_sans_active();
     void toggle_auto_tile();
+    void retile();
+    void schedule_layout();
+    void layout();
+    void schedule_visibility();
+    void update_visibility();
     void adjust_neighbors_on_resize(Toplevel *resized, const wlr_box &old_geo);
     std::vector<Toplevel *> fullscreen_toplevels();
     std::vector<Toplevel *> pinned();
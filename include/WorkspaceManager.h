@@ -5,6 +5,9 @@
 #include <map>
 #include <string>
 
+// workspace numbers run from 1 to this, each is created on first use
+constexpr uint32_t WORKSPACE_COUNT = 10;
+
 struct OrphanedOutput {
     uint32_t active_num;
     std::vector<Workspace *> workspaces;
@@ -14,18 +17,24 @@ struct WorkspaceManager {
     Server *server;
     struct wl_list workspaces;
     std::map<std::string, OrphanedOutput> orphaned_outputs_map;
+    wl_event_source *pending_idle{nullptr};
 
     WorkspaceManager(Server *server);
     ~WorkspaceManager();
 
     Workspace *new_workspace(Output *output, uint32_t num = 0);
     Workspace *get_workspace(uint32_t num, Output *output = nullptr) const;
+    Workspace *ensure_workspace(uint32_t num, Output *output);
     Workspace *get_active_workspace(Output *output) const;
     bool set_workspace(Workspace *workspace);
     bool set_workspace(uint32_t num, Output *output);
 
     Workspace *get_workspace_for_toplevel(Toplevel *toplevel) const;
 
+    void schedule_idle();
+    void flush_layouts();
+    void flush_visibility();
+
     void orphanize_workspaces(Output *output);
     bool adopt_workspaces(Output *output);
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Notifier.h"
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -14,25 +15,26 @@
 template <typename... Args>
 void notify_send(const std::string title, const std::string &format,
                  Args... args) {
-    // format message
-    const int size_s = std::snprintf(nullptr, 0, format.c_str(), args...) + 1;
-    if (size_s <= 0)
+    // format message, only long ones are formatted a second time
+    char stack[256];
+    const int size_s =
+        std::snprintf(stack, sizeof(stack), format.c_str(), args...);
+    if (size_s < 0)
         throw std::runtime_error("Error during formatting.");
-    const auto size = static_cast<size_t>(size_s);
-    std::unique_ptr<char[]> buf(new char[size]);
-    std::snprintf(buf.get(), size, format.c_str(), args...);
-    const std::string message = std::string(buf.get(), buf.get() + size - 1);
+
+    std::string message;
+    if (static_cast<size_t>(size_s) < sizeof(stack)) {
+        message.assign(stack, size_s);
+    } else {
+        message.resize(size_s);
+        std::snprintf(message.data(), size_s + 1, format.c_str(), args...);
+    }
 
     // log
     wlr_log(WLR_INFO, "%s", message.c_str());
 
-    // send notification
-    if (fork() == 0) {
-        execl("/bin/sh", "/bin/sh", "-c",
-              ("notify-send -a awm \"" + title + "\" \"" + message + "\"")
-                  .c_str(),
-              nullptr);
-    }
+    // the notifier batches it and sends it from the event loop
+    queue_notification(title, message);
 }
 
 #pragma GCC diagnostic pop
@@ -9,6 +9,15 @@ ActivationToken::ActivationToken(Server *server,
     had_focus = token->surface != nullptr;
     token->data = this;
 
+    // tokens expire, the pointer is dropped with the token
+    destroy.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
+        ActivationToken *token = wl_container_of(listener, token, destroy);
+        wl_list_remove(&token->destroy.link);
+        wl_list_init(&token->destroy.link);
+        token->token = nullptr;
+    };
+    wl_signal_add(&token->events.destroy, &destroy);
+
     wl_list_init(&link);
     wl_list_insert(&server->pending_activation_tokens, &link);
 }
@@ -20,6 +29,8 @@ ActivationToken::~ActivationToken() {
     if (!wl_list_empty(&link))
         wl_list_remove(&link);
 
+    wl_list_remove(&destroy.link);
+
     if (token)
         token->data = nullptr;
 }
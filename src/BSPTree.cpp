@@ -6,88 +6,112 @@
 #include <algorithm>
 #include <functional>
 
-BSPNode *BSPNode::find_toplevel(Toplevel *tl) {
-    if (is_leaf())
-        return toplevel == tl ? this : nullptr;
+void BSPNode::get_toplevels(std::vector<Toplevel *> &toplevels) const {
+    if (is_leaf()) {
+        if (toplevel)
+            toplevels.push_back(toplevel);
+        return;
+    }
 
     if (first_child)
-        if (BSPNode *found = first_child->find_toplevel(tl))
-            return found;
-
+        first_child->get_toplevels(toplevels);
     if (second_child)
-        if (BSPNode *found = second_child->find_toplevel(tl))
-            return found;
-
-    return nullptr;
+        second_child->get_toplevels(toplevels);
 }
 
-bool BSPNode::remove_toplevel(Toplevel *tl) {
-    if (is_leaf()) {
-        if (toplevel == tl) {
-            toplevel = nullptr;
-            return true;
-        }
-        return false;
+BSPNode *BSPNode::find_insertion_point() {
+    BSPNode *node = this;
+    while (!node->is_leaf()) {
+        int first_count = node->first_child ? node->first_child->leaves : 0;
+        int second_count = node->second_child ? node->second_child->leaves : 0;
+
+        if (first_count <= second_count && node->first_child)
+            node = node->first_child;
+        else if (node->second_child)
+            node = node->second_child;
+        else if (node->first_child)
+            node = node->first_child;
+        else
+            break;
     }
 
-    bool removed = false;
-    if (first_child && first_child->remove_toplevel(tl))
-        removed = true;
-    if (second_child && second_child->remove_toplevel(tl))
-        removed = true;
+    return node;
+}
 
-    return removed;
+// flag this node for recalculation and make it reachable from the root
+void BSPNode::mark_dirty() {
+    dirty = true;
+    for (BSPNode *p = parent; p && !p->child_dirty; p = p->parent)
+        p->child_dirty = true;
 }
 
-void BSPNode::get_toplevels(std::vector<Toplevel *> &toplevels) const {
-    if (is_leaf()) {
-        if (toplevel)
-            toplevels.push_back(toplevel);
-        return;
+// refresh cached leaf counts from this node up to the root
+void BSPNode::update_leaves() {
+    for (BSPNode *node = this; node; node = node->parent) {
+        if (node->is_leaf())
+            node->leaves = node->toplevel ? 1 : 0;
+        else
+            node->leaves =
+                (node->first_child ? node->first_child->leaves : 0) +
+                (node->second_child ? node->second_child->leaves : 0);
     }
+}
 
-    if (first_child)
-        first_child->get_toplevels(toplevels);
-    if (second_child)
-        second_child->get_toplevels(toplevels);
+BSPNode *BSPTree::alloc_node(Toplevel *toplevel) {
+    BSPNode *node;
+    if (free_nodes.empty())
+        node = &pool.emplace_back(toplevel);
+    else {
+        node = free_nodes.back();
+        free_nodes.pop_back();
+        *node = BSPNode(toplevel);
+    }
+
+    if (toplevel)
+        leaf_nodes[toplevel] = node;
+
+    return node;
 }
 
-int BSPNode::count_leaves() const {
-    if (is_leaf())
-        return toplevel ? 1 : 0;
+void BSPTree::free_node(BSPNode *node) {
+    *node = BSPNode();
+    free_nodes.push_back(node);
+}
 
-    int count = 0;
-    if (first_child)
-        count += first_child->count_leaves();
-    if (second_child)
-        count += second_child->count_leaves();
+void BSPTree::set_leaf(BSPNode *node, Toplevel *toplevel) {
+    node->toplevel = toplevel;
+    node->split = SplitType::NONE;
+
+    if (toplevel)
+        leaf_nodes[toplevel] = node;
 
-    return count;
+    node->update_leaves();
 }
 
-BSPNode *BSPNode::find_insertion_point() {
-    if (is_leaf())
-        return this;
+// turn a leaf into a container holding its toplevel and the new one
+void BSPTree::split_leaf(BSPNode *leaf, Toplevel *toplevel, SplitType split) {
+    Toplevel *existing = leaf->toplevel;
+    leaf->toplevel = nullptr;
+
+    leaf->split = split;
+    leaf->ratio = 0.5f;
 
-    int first_count = first_child ? first_child->count_leaves() : 0;
-    int second_count = second_child ? second_child->count_leaves() : 0;
+    leaf->first_child = alloc_node(existing);
+    leaf->first_child->parent = leaf;
 
-    if (first_count <= second_count && first_child)
-        return first_child->find_insertion_point();
-    else if (second_child)
-        return second_child->find_insertion_point();
-    else if (first_child)
-        return first_child->find_insertion_point();
+    leaf->second_child = alloc_node(toplevel);
+    leaf->second_child->parent = leaf;
 
-    return this;
+    leaf->update_leaves();
+    leaf->mark_dirty();
 }
 
 void BSPTree::insert(Toplevel *toplevel) {
-    if (!toplevel)
+    if (!toplevel || leaf_nodes.count(toplevel))
         return;
 
     if (!root) {
-        root = std::make_unique<BSPNode>(toplevel);
+        root = alloc_node(toplevel);
         return;
     }
 
@@ -95,25 +119,16 @@ void BSPTree::insert(Toplevel *toplevel) {
     if (!insertion_point || !insertion_point->is_leaf())
         return;
 
-    Toplevel *existing = insertion_point->toplevel;
-    insertion_point->toplevel = nullptr;
-
-    insertion_point->split = determine_split_type(insertion_point);
-    insertion_point->ratio = 0.5f;
-
-    insertion_point->first_child = std::make_unique<BSPNode>(existing);
-    insertion_point->first_child->parent = insertion_point;
-
-    insertion_point->second_child = std::make_unique<BSPNode>(toplevel);
-    insertion_point->second_child->parent = insertion_point;
+    split_leaf(insertion_point, toplevel,
+               determine_split_type(insertion_point));
 }
 
 void BSPTree::insert_at(Toplevel *toplevel, Toplevel *target) {
-    if (!toplevel)
+    if (!toplevel || leaf_nodes.count(toplevel))
         return;
 
     if (!root) {
-        root = std::make_unique<BSPNode>(toplevel);
+        root = alloc_node(toplevel);
         return;
     }
 
@@ -124,80 +139,59 @@ void BSPTree::insert_at(Toplevel *toplevel, Toplevel *target) {
         return;
     }
 
-    Toplevel *existing = target_node->toplevel;
-    target_node->toplevel = nullptr;
-
-    target_node->split = determine_split_type(target_node);
-    target_node->ratio = 0.5f;
-
-    target_node->first_child = std::make_unique<BSPNode>(existing);
-    target_node->first_child->parent = target_node;
-
-    target_node->second_child = std::make_unique<BSPNode>(toplevel);
-    target_node->second_child->parent = target_node;
+    split_leaf(target_node, toplevel, determine_split_type(target_node));
 }
 
 void BSPTree::remove(Toplevel *toplevel) {
     if (!root || !toplevel)
         return;
 
-    BSPNode *node = find_node(toplevel);
-    if (!node || !node->is_leaf())
+    auto it = leaf_nodes.find(toplevel);
+    if (it == leaf_nodes.end())
         return;
 
+    BSPNode *node = it->second;
+    leaf_nodes.erase(it);
+
     node->toplevel = nullptr;
 
     BSPNode *parent = node->parent;
 
     if (!parent) {
-        root.reset();
+        clear();
         return;
     }
 
     BSPNode *sibling = nullptr;
-    if (parent->first_child.get() == node)
-        sibling = parent->second_child.get();
+    if (parent->first_child == node)
+        sibling = parent->second_child;
     else
-        sibling = parent->first_child.get();
+        sibling = parent->first_child;
 
-    if (!sibling)
+    if (!sibling) {
+        node->update_leaves();
         return;
+    }
 
-    if (!parent->parent) {
-        root->split = sibling->split;
-        root->ratio = sibling->ratio;
-        root->toplevel = sibling->toplevel;
-        root->first_child = std::move(sibling->first_child);
-        root->second_child = std::move(sibling->second_child);
+    // the sibling takes the place of its parent
+    BSPNode *grandparent = parent->parent;
+    sibling->parent = grandparent;
 
-        if (root->first_child)
-            root->first_child->parent = root.get();
-        if (root->second_child)
-            root->second_child->parent = root.get();
+    if (!grandparent)
+        root = sibling;
+    else if (grandparent->first_child == parent)
+        grandparent->first_child = sibling;
+    else
+        grandparent->second_child = sibling;
 
-        return;
-    }
+    free_node(parent);
+    free_node(node);
 
-    BSPNode *grandparent = parent->parent;
-    if (grandparent->first_child.get() == parent) {
-        std::unique_ptr<BSPNode> sibling_ptr;
-        if (parent->first_child.get() == node)
-            sibling_ptr = std::move(parent->second_child);
-        else
-            sibling_ptr = std::move(parent->first_child);
-
-        sibling_ptr->parent = grandparent;
-        grandparent->first_child = std::move(sibling_ptr);
-    } else {
-        std::unique_ptr<BSPNode> sibling_ptr;
-        if (parent->first_child.get() == node)
-            sibling_ptr = std::move(parent->second_child);
-        else
-            sibling_ptr = std::move(parent->first_child);
+    if (grandparent)
+        grandparent->update_leaves();
 
-        sibling_ptr->parent = grandparent;
-        grandparent->second_child = std::move(sibling_ptr);
-    }
+    // the sibling now fills the space of its old parent
+    sibling->mark_dirty();
 }
 
 void BSPTree::apply_layout(const wlr_box &bounds, bool use_transaction) {
@@ -207,17 +201,28 @@ void BSPTree::apply_layout(const wlr_box &bounds, bool use_transaction) {
     if (use_transaction)
         workspace->output->server->transaction_manager->begin();
 
-    calculate_layout(root.get(), bounds);
-    apply_geometries(root.get(), !use_transaction);
+    calculate_layout(root, bounds);
+    apply_geometries(root, !use_transaction);
 
     if (use_transaction)
         workspace->output->server->transaction_manager->commit();
 }
 
 BSPNode *BSPTree::find_node(Toplevel *toplevel) {
-    if (!root)
-        return nullptr;
-    return root->find_toplevel(toplevel);
+    auto it = leaf_nodes.find(toplevel);
+    return it == leaf_nodes.end() ? nullptr : it->second;
+}
+
+// a toplevel moved or resized outside the tree, flag its leaf so the next
+// layout puts it back into its slot
+void BSPTree::check_leaf(Toplevel *toplevel) {
+    BSPNode *node = find_node(toplevel);
+    if (!node || node->dirty)
+        return;
+
+    wlr_box current = toplevel->target_geometry();
+    if (!wlr_box_equal(&current, &node->geometry))
+        node->mark_dirty();
 }
 
 bool BSPTree::get_toplevel_geometry(Toplevel *toplevel, const wlr_box &bounds,
@@ -225,7 +230,7 @@ bool BSPTree::get_toplevel_geometry(Toplevel *toplevel, const wlr_box &bounds,
     if (!root || !toplevel)
         return false;
 
-    calculate_layout(root.get(), bounds);
+    calculate_layout(root, bounds);
 
     BSPNode *node = find_node(toplevel);
     if (!node || !node->is_leaf())
@@ -239,7 +244,12 @@ void BSPTree::adjust_ratio(BSPNode *node, float new_ratio) {
     if (!node || node->is_leaf())
         return;
 
-    node->ratio = std::max(0.1f, std::min(0.9f, new_ratio));
+    new_ratio = std::max(0.1f, std::min(0.9f, new_ratio));
+    if (new_ratio == node->ratio)
+        return;
+
+    node->ratio = new_ratio;
+    node->mark_dirty();
 }
 
 void BSPTree::handle_resize(Toplevel *toplevel, const wlr_box &new_geo) {
@@ -284,10 +294,10 @@ void BSPTree::rebuild_grid(std::vector<Toplevel *> toplevels) {
     int cols = (count + rows - 1) / rows;
 
     // bsp tree for grid
-    root = std::make_unique<BSPNode>();
+    root = alloc_node();
 
     if (count == 1) {
-        root->toplevel = tiled[0];
+        set_leaf(root, tiled[0]);
         return;
     }
 
@@ -303,8 +313,7 @@ void BSPTree::rebuild_grid(std::vector<Toplevel *> toplevels) {
 
         if (num_windows == 1) {
             // leaf node
-            node->toplevel = tiled[start_idx];
-            node->split = SplitType::NONE;
+            set_leaf(node, tiled[start_idx]);
             return;
         }
 
@@ -322,14 +331,14 @@ void BSPTree::rebuild_grid(std::vector<Toplevel *> toplevels) {
             node->split = SplitType::HORIZONTAL;
             node->ratio = static_cast<float>(windows_in_first) / num_windows;
 
-            node->first_child = std::make_unique<BSPNode>();
+            node->first_child = alloc_node();
             node->first_child->parent = node;
-            build_grid_node(node->first_child.get(), start_idx, mid_idx,
+            build_grid_node(node->first_child, start_idx, mid_idx,
                             start_row, mid_row, depth + 1);
 
-            node->second_child = std::make_unique<BSPNode>();
+            node->second_child = alloc_node();
             node->second_child->parent = node;
-            build_grid_node(node->second_child.get(), mid_idx, end_idx, mid_row,
+            build_grid_node(node->second_child, mid_idx, end_idx, mid_row,
                             end_row, depth + 1);
         } else {
             // single row
@@ -338,19 +347,19 @@ void BSPTree::rebuild_grid(std::vector<Toplevel *> toplevels) {
             node->split = SplitType::VERTICAL;
             node->ratio = 0.5f;
 
-            node->first_child = std::make_unique<BSPNode>();
+            node->first_child = alloc_node();
             node->first_child->parent = node;
-            build_grid_node(node->first_child.get(), start_idx, mid_idx,
+            build_grid_node(node->first_child, start_idx, mid_idx,
                             start_row, end_row, depth + 1);
 
-            node->second_child = std::make_unique<BSPNode>();
+            node->second_child = alloc_node();
             node->second_child->parent = node;
-            build_grid_node(node->second_child.get(), mid_idx, end_idx,
+            build_grid_node(node->second_child, mid_idx, end_idx,
                             start_row, end_row, depth + 1);
         }
     };
 
-    build_grid_node(root.get(), 0, count, 0, rows, 0);
+    build_grid_node(root, 0, count, 0, rows, 0);
 }
 
 void BSPTree::rebuild_dwindle(std::vector<Toplevel *> toplevels) {
@@ -371,10 +380,10 @@ void BSPTree::rebuild_dwindle(std::vector<Toplevel *> toplevels) {
     int count = tiled.size();
 
     // build dwindle tree
-    root = std::make_unique<BSPNode>();
+    root = alloc_node();
 
     if (count == 1) {
-        root->toplevel = tiled[0];
+        set_leaf(root, tiled[0]);
         return;
     }
 
@@ -389,8 +398,7 @@ void BSPTree::rebuild_dwindle(std::vector<Toplevel *> toplevels) {
 
         if (num_windows == 1) {
             // leaf node
-            node->toplevel = tiled[start_idx];
-            node->split = SplitType::NONE;
+            set_leaf(node, tiled[start_idx]);
             return;
         }
 
@@ -400,34 +408,32 @@ void BSPTree::rebuild_dwindle(std::vector<Toplevel *> toplevels) {
         node->ratio = 0.5f;
 
         // 1st child
-        node->first_child = std::make_unique<BSPNode>();
+        node->first_child = alloc_node();
         node->first_child->parent = node;
-        node->first_child->toplevel = tiled[start_idx];
-        node->first_child->split = SplitType::NONE;
+        set_leaf(node->first_child, tiled[start_idx]);
 
         // 2nd child
-        node->second_child = std::make_unique<BSPNode>();
+        node->second_child = alloc_node();
         node->second_child->parent = node;
 
         if (num_windows == 2) {
-            node->second_child->toplevel = tiled[start_idx + 1];
-            node->second_child->split = SplitType::NONE;
+            set_leaf(node->second_child, tiled[start_idx + 1]);
         } else {
             // recursively split the rest with alternating direction
-            build_dwindle_node(node->second_child.get(), start_idx + 1, end_idx,
+            build_dwindle_node(node->second_child, start_idx + 1, end_idx,
                                !is_horizontal);
         }
     };
 
-    build_dwindle_node(root.get(), 0, count, true);
+    build_dwindle_node(root, 0, count, true);
 }
 
 void BSPTree::insert_at_dwindle(Toplevel *toplevel, Toplevel *target) {
-    if (!toplevel)
+    if (!toplevel || leaf_nodes.count(toplevel))
         return;
 
     if (!root) {
-        root = std::make_unique<BSPNode>(toplevel);
+        root = alloc_node(toplevel);
         return;
     }
 
@@ -443,31 +449,124 @@ void BSPTree::insert_at_dwindle(Toplevel *toplevel, Toplevel *target) {
     }
 
     // Split the target node horizontally (active on left, new on right)
-    Toplevel *existing = target_node->toplevel;
-    target_node->toplevel = nullptr;
+    split_leaf(target_node, toplevel, SplitType::HORIZONTAL);
+}
 
-    target_node->split = SplitType::HORIZONTAL;
-    target_node->ratio = 0.5f;
+// exchange the leaves holding two toplevels
+bool BSPTree::swap(Toplevel *a, Toplevel *b) {
+    auto it_a = leaf_nodes.find(a);
+    auto it_b = leaf_nodes.find(b);
+    if (it_a == leaf_nodes.end() || it_b == leaf_nodes.end())
+        return false;
 
-    // Active window goes on the left (first child)
-    target_node->first_child = std::make_unique<BSPNode>(existing);
-    target_node->first_child->parent = target_node;
+    BSPNode *node_a = it_a->second;
+    BSPNode *node_b = it_b->second;
+
+    node_a->toplevel = b;
+    node_b->toplevel = a;
+    it_a->second = node_b;
+    it_b->second = node_a;
+
+    node_a->mark_dirty();
+    node_b->mark_dirty();
+    return true;
+}
+
+void BSPTree::clear() {
+    root = nullptr;
+    leaf_nodes.clear();
+
+    // keep the pool allocated for the next rebuild
+    free_nodes.clear();
+    for (BSPNode &node : pool) {
+        node = BSPNode();
+        free_nodes.push_back(&node);
+    }
+}
+
+// capture the shape of the tree, id maps each toplevel to the leaf id
+BSPShape BSPTree::save(const std::function<int(Toplevel *)> &id) const {
+    std::function<BSPShape(const BSPNode *)> capture =
+        [&](const BSPNode *node) {
+            BSPShape shape;
+            shape.split = node->split;
+            shape.ratio = node->ratio;
+
+            if (node->is_leaf())
+                shape.leaf = node->toplevel ? id(node->toplevel) : -1;
+            else {
+                shape.children.push_back(capture(node->first_child));
+                shape.children.push_back(capture(node->second_child));
+            }
+
+            return shape;
+        };
+
+    return root ? capture(root) : BSPShape{};
+}
+
+// build a subtree from a shape, leaves lookup cannot resolve are dropped and
+// containers left with one child collapse into it
+BSPNode *BSPTree::build(const BSPShape &shape,
+                        const std::function<Toplevel *(int)> &lookup) {
+    if (shape.split == SplitType::NONE || shape.children.size() != 2) {
+        Toplevel *toplevel = shape.leaf >= 0 ? lookup(shape.leaf) : nullptr;
+        if (!toplevel || leaf_nodes.count(toplevel))
+            return nullptr;
+
+        return alloc_node(toplevel);
+    }
 
-    // New window goes on the right (second child)
-    target_node->second_child = std::make_unique<BSPNode>(toplevel);
-    target_node->second_child->parent = target_node;
+    BSPNode *first = build(shape.children[0], lookup);
+    BSPNode *second = build(shape.children[1], lookup);
+    if (!first || !second)
+        return first ? first : second;
+
+    BSPNode *node = alloc_node();
+    node->split = shape.split;
+    node->ratio = shape.ratio;
+    node->first_child = first;
+    node->second_child = second;
+    first->parent = node;
+    second->parent = node;
+    node->leaves = first->leaves + second->leaves;
+
+    return node;
 }
 
-void BSPTree::clear() { root.reset(); }
+// rebuild the tree from a saved shape, toplevels in the tree that the shape
+// does not place are inserted again afterwards
+void BSPTree::restore(const BSPShape &shape,
+                      const std::function<Toplevel *(int)> &lookup) {
+    std::vector<Toplevel *> previous;
+    if (root)
+        root->get_toplevels(previous);
 
-void BSPTree::calculate_layout(BSPNode *node, const wlr_box &bounds) {
+    clear();
+    root = build(shape, lookup);
+
+    for (Toplevel *toplevel : previous)
+        insert(toplevel);
+}
+
+// recalculate dirty subtrees, returns true if any leaf below may have moved
+bool BSPTree::calculate_layout(BSPNode *node, const wlr_box &bounds) {
     if (!node)
-        return;
+        return false;
+
+    // nothing changed in this subtree
+    if (!node->dirty && !node->child_dirty &&
+        wlr_box_equal(&node->geometry, &bounds))
+        return false;
 
     node->geometry = bounds;
+    node->dirty = false;
+    node->child_dirty = false;
 
-    if (node->is_leaf())
-        return;
+    if (node->is_leaf()) {
+        node->needs_apply = true;
+        return true;
+    }
 
     wlr_box first_bounds = bounds;
     wlr_box second_bounds = bounds;
@@ -486,68 +585,92 @@ void BSPTree::calculate_layout(BSPNode *node, const wlr_box &bounds) {
         second_bounds.height = bounds.height - first_bounds.height;
     }
 
+    // children whose bounds did not change and are clean are skipped
+    bool changed = false;
     if (node->first_child)
-        calculate_layout(node->first_child.get(), first_bounds);
+        changed |= calculate_layout(node->first_child, first_bounds);
     if (node->second_child)
-        calculate_layout(node->second_child.get(), second_bounds);
+        changed |= calculate_layout(node->second_child, second_bounds);
+
+    if (changed)
+        node->needs_apply = true;
+
+    return changed;
 }
 
 void BSPTree::apply_geometries(BSPNode *node, bool immediate) {
-    if (!node)
+    if (!node || !node->needs_apply)
         return;
 
     if (node->is_leaf() && node->toplevel) {
-        if (!node->toplevel->maximized() && !node->toplevel->fullscreen()) {
-            if (immediate) {
-                Toplevel *tl = node->toplevel;
-                wlr_box &geo = node->geometry;
+        Toplevel *tl = node->toplevel;
 
-                tl->geometry = geo;
+        // the requested state counts, a leaf re-inserted by unmaximize is
+        // laid out before the client commits it. a skipped leaf stays
+        // pending and reachable for the next layout
+        if (tl->requested_maximized() || tl->fullscreen()) {
+            node->mark_dirty();
+            return;
+        }
 
-                int x = geo.x;
-                int y = geo.y;
+        node->needs_apply = false;
+
+        // skip leaves whose box did not actually change
+        wlr_box current = tl->target_geometry();
+        if (!tl->scene_hidden_for_autotile &&
+            wlr_box_equal(&current, &node->geometry))
+            return;
 
-                // remove decoration height from window height
-                int width = geo.width;
-                int height = geo.height;
+        if (immediate) {
+            wlr_box &geo = node->geometry;
 
-                // apply decoration offset if decoration is visible
-                if (tl->decoration &&
-                    tl->decoration_mode ==
-                        WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE &&
-                    tl->decoration->visible) {
-                    int deco_height = 30;
-                    y += deco_height;
-                    height -= deco_height;
-                }
+            tl->set_geometry(geo);
 
-                wlr_scene_node_set_position(&tl->scene_tree->node, x, y);
+            int x = geo.x;
+            int y = geo.y;
+
+            // remove decoration height from window height
+            int width = geo.width;
+            int height = geo.height;
+
+            // apply decoration offset if decoration is visible
+            if (tl->decoration &&
+                tl->decoration_mode ==
+                    WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE &&
+                tl->decoration->visible) {
+                int deco_height = 30;
+                y += deco_height;
+                height -= deco_height;
+            }
+
+            wlr_scene_node_set_position(&tl->scene_tree->node, x, y);
 
 #ifdef XWAYLAND
-                if (tl->xdg_toplevel) {
+            if (tl->xdg_toplevel) {
 #endif
-                    wlr_xdg_toplevel_set_size(tl->xdg_toplevel, width, height);
-                    wlr_xdg_surface_schedule_configure(tl->xdg_toplevel->base);
+                wlr_xdg_toplevel_set_size(tl->xdg_toplevel, width, height);
+                wlr_xdg_surface_schedule_configure(tl->xdg_toplevel->base);
 #ifdef XWAYLAND
-                } else if (tl->xwayland_surface) {
-                    wlr_xwayland_surface_configure(tl->xwayland_surface, geo.x,
-                                                   geo.y, width, height);
-                }
+            } else if (tl->xwayland_surface) {
+                wlr_xwayland_surface_configure(tl->xwayland_surface, geo.x,
+                                               geo.y, width, height);
+            }
 #endif
 
-                if (tl->decoration)
-                    tl->decoration->update_titlebar(geo.width);
-            } else {
-                node->toplevel->set_position_size(node->geometry);
-            }
+            if (tl->decoration)
+                tl->decoration->update_titlebar(geo.width);
+        } else {
+            tl->set_position_size(node->geometry);
         }
         return;
     }
 
+    node->needs_apply = false;
+
     if (node->first_child)
-        apply_geometries(node->first_child.get(), immediate);
+        apply_geometries(node->first_child, immediate);
     if (node->second_child)
-        apply_geometries(node->second_child.get(), immediate);
+        apply_geometries(node->second_child, immediate);
 }
 
 void BSPTree::dump_tree(BSPNode *node, int depth) {
@@ -558,9 +681,9 @@ void BSPTree::dump_tree(BSPNode *node, int depth) {
 
     if (!node->is_leaf()) {
         if (node->first_child)
-            dump_tree(node->first_child.get(), depth + 1);
+            dump_tree(node->first_child, depth + 1);
         if (node->second_child)
-            dump_tree(node->second_child.get(), depth + 1);
+            dump_tree(node->second_child, depth + 1);
     }
 }
 
@@ -579,9 +702,9 @@ BSPNode *BSPTree::find_resize_sibling(BSPNode *node) {
         return nullptr;
 
     BSPNode *parent = node->parent;
-    BSPNode *sibling = (parent->first_child.get() == node)
-                           ? parent->second_child.get()
-                           : parent->first_child.get();
+    BSPNode *sibling = (parent->first_child == node)
+                           ? parent->second_child
+                           : parent->first_child;
 
     return sibling;
 }
@@ -591,7 +714,7 @@ float BSPTree::calculate_ratio_from_resize(BSPNode *parent, BSPNode *child,
     if (!parent || parent->is_leaf())
         return -1.0f;
 
-    bool is_first = parent->first_child.get() == child;
+    bool is_first = parent->first_child == child;
     if (parent->split == SplitType::HORIZONTAL) {
         int new_width = new_geo.width;
         int total_width = parent->geometry.width;
@@ -623,7 +746,7 @@ BSPNode *BSPTree::find_resize_parent(Toplevel *toplevel, uint32_t edges) {
         return nullptr;
 
     BSPNode *parent = node->parent;
-    bool is_first = parent->first_child.get() == node;
+    bool is_first = parent->first_child == node;
 
     if (parent->split == SplitType::HORIZONTAL) {
         if (is_first && (edges & WLR_EDGE_RIGHT))
@@ -648,7 +771,7 @@ BSPNode *BSPTree::find_resize_parent_recursive(BSPNode *node, uint32_t edges) {
         return nullptr;
 
     BSPNode *parent = node->parent;
-    bool is_first = parent->first_child.get() == node;
+    bool is_first = parent->first_child == node;
 
     if (parent->split == SplitType::HORIZONTAL) {
         if (is_first && (edges & WLR_EDGE_RIGHT))
@@ -672,7 +795,7 @@ void BSPTree::handle_interactive_resize(Toplevel *toplevel, uint32_t edges,
     if (!node)
         return;
 
-    calculate_layout(root.get(), bounds);
+    calculate_layout(root, bounds);
 
     std::vector<std::pair<BSPNode *, BSPNode *>> parents_to_adjust;
 
@@ -680,7 +803,7 @@ void BSPTree::handle_interactive_resize(Toplevel *toplevel, uint32_t edges,
     BSPNode *current = node;
     while (current && current->parent) {
         BSPNode *parent = current->parent;
-        bool is_first = parent->first_child.get() == current;
+        bool is_first = parent->first_child == current;
 
         bool should_adjust = false;
         uint32_t next_edges = 0;
@@ -726,8 +849,6 @@ void BSPTree::handle_interactive_resize(Toplevel *toplevel, uint32_t edges,
         if (new_ratio >= 0.0f)
             adjust_ratio(parent, new_ratio);
     }
-
-    dump_tree(root.get(), 0);
 }
 
 float BSPTree::calculate_ratio_from_cursor(BSPNode *parent, BSPNode *child,
@@ -736,7 +857,7 @@ float BSPTree::calculate_ratio_from_cursor(BSPNode *parent, BSPNode *child,
     if (!parent || parent->is_leaf())
         return -1.0f;
 
-    bool is_first = parent->first_child.get() == child;
+    bool is_first = parent->first_child == child;
 
     if (parent->split == SplitType::HORIZONTAL) {
         int relative_x = cursor_x - parent->geometry.x;
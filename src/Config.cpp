@@ -1,15 +1,17 @@
 #include "Config.h"
-#include "Cursor.h"
-#include "Keyboard.h"
-#include "Seat.h"
-#include "Server.h"
+#include "Toml.h"
 #include "util.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <libinput.h>
-#include <memory>
-#include <optional>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 
 // get the wlr modifier enum value from the string representation
 uint32_t parse_modifier(const std::string &modifier) {
@@ -71,686 +73,818 @@ cont:
     return bind;
 }
 
-// add bind to binds if valid
-void Config::set_bind(const std::string &name, const toml::Table *source,
-                      const BindName target) {
-    if (!source)
-        return;
+// where a value sits in the config file, only turned into a string for
+// messages
+struct KeyPath {
+    const KeyPath *parent;
+    const char *key;
 
-    if (auto value = source->getString(name)) {
-        if (const Bind *bind = parse_bind(*value, target)) {
-            binds.emplace_back(*bind);
-            delete bind;
-        }
+    std::string str() const {
+        return parent ? parent->str() + "." + key : std::string(key);
+    }
+};
+
+// a key of a config table and how its value is written into an object
+template <typename T> struct Key {
+    using owner = T;
+
+    const char *name;
+    void (*bind)(T &object, const toml_table_t *table, const KeyPath &path);
+};
+
+// a string option and the value it stands for
+template <typename T> struct Choice {
+    const char *name;
+    T value;
+};
+
+template <typename M> struct member_traits;
+template <typename T, typename S> struct member_traits<T S::*> {
+    using owner = S;
+    using type = T;
+};
+
+template <auto member>
+using member_owner = typename member_traits<decltype(member)>::owner;
+
+template <auto member>
+using member_type = typename member_traits<decltype(member)>::type;
+
+template <const auto &keys>
+using schema_owner = typename std::remove_cv_t<
+    std::remove_extent_t<std::remove_reference_t<decltype(keys)>>>::owner;
+
+static void report_type(const KeyPath &path) {
+    notify_send("Config", "Wrong type for option '%s'", path.str().c_str());
+}
+
+// write every key of a table into an object, unknown keys are reported
+template <typename T, size_t N>
+static void walk(T &object, const Key<T> (&keys)[N], const toml_table_t *table,
+                 const KeyPath *parent) {
+    for (int i = 0; const char *name = toml_key_in(table, i); ++i) {
+        const KeyPath path{parent, name};
+
+        const Key<T> *key =
+            std::find_if(std::begin(keys), std::end(keys),
+                         [&](const Key<T> &k) { return !strcmp(k.name, name); });
+
+        if (key != std::end(keys))
+            key->bind(object, table, path);
+        else
+            notify_send("Config", "Unknown option '%s'", path.str().c_str());
     }
 }
 
-// Helper to map string options to enum values
-template <typename T>
-std::optional<T> map_option(const std::string &name,
-                            const std::unordered_map<std::string, T> &options,
-                            const std::optional<std::string> &value) {
-    if (!value)
-        return std::nullopt;
-
-    auto it = options.find(*value);
-    if (it != options.end())
-        return it->second;
-
-    // Build error message with available options
-    std::string opts_str;
-    for (const auto &[key, _] : options) {
-        if (!opts_str.empty())
-            opts_str += "', '";
-        opts_str += key;
+// plain values, enums without choices are switched by a boolean
+template <auto member>
+static void value(member_owner<member> &object, const toml_table_t *table,
+                  const KeyPath &path) {
+    using T = member_type<member>;
+    bool ok;
+
+    if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, std::string>) {
+        ok = toml::read(table, path.key, object.*member);
+    } else if constexpr (std::is_enum_v<T>) {
+        bool b{false};
+        if ((ok = toml::read(table, path.key, b)))
+            object.*member = static_cast<T>(b);
+    } else if constexpr (std::is_integral_v<T>) {
+        int64_t i{0};
+        if ((ok = toml::read(table, path.key, i)))
+            object.*member = static_cast<T>(i);
+    } else {
+        double d{0.0};
+        if ((ok = toml::read(table, path.key, d)))
+            object.*member = static_cast<T>(d);
     }
 
-    notify_send("Config", "No such option in %s ['%s']: %s", name.c_str(),
-                opts_str.c_str(), value->c_str());
-    return std::nullopt;
+    if (!ok)
+        report_type(path);
 }
 
-Config::Config()
-    : path(""), last_write_time(std::filesystem::file_time_type::min()) {
-    binds = {Bind{BIND_EXIT, WLR_MODIFIER_ALT, XKB_KEY_Escape}};
-    notify_send("Config", "%s",
-                "no config loaded, press Alt+Escape to exit awm");
+// look up the value named by a string option
+template <typename T, size_t N>
+static bool read_choice(const Choice<T> (&choices)[N],
+                        const toml_table_t *table, const KeyPath &path,
+                        T &out) {
+    std::string name;
+    if (!toml::read(table, path.key, name)) {
+        report_type(path);
+        return false;
+    }
+
+    for (const Choice<T> &choice : choices)
+        if (name == choice.name) {
+            out = choice.value;
+            return true;
+        }
+
+    // build error message with available options
+    std::string options;
+    for (const Choice<T> &choice : choices) {
+        if (!options.empty())
+            options += "', '";
+        options += choice.name;
+    }
+
+    notify_send("Config", "No such option in %s ['%s']: %s",
+                path.str().c_str(), options.c_str(), name.c_str());
+    return false;
 }
 
-Config::Config(const std::string &path) : path(path) {
-    // get last write time
-    last_write_time = std::filesystem::last_write_time(path);
+template <auto member, const auto &choices>
+static void choice(member_owner<member> &object, const toml_table_t *table,
+                   const KeyPath &path) {
+    read_choice(choices, table, path, object.*member);
+}
 
-    // load config at path
-    load();
+// subtables written into a member
+template <auto member, const auto &keys>
+static void section(member_owner<member> &object, const toml_table_t *table,
+                    const KeyPath &path) {
+    if (const toml_table_t *subtable = toml_table_in(table, path.key))
+        walk(object.*member, keys, subtable, &path);
+    else
+        report_type(path);
 }
 
-// load config from path
-bool Config::load() {
-    // read in config file
-    toml::ParseResult config_file = toml::parseFile(path);
+// subtables written into the object itself
+template <const auto &keys>
+static void flat(schema_owner<keys> &object, const toml_table_t *table,
+                 const KeyPath &path) {
+    if (const toml_table_t *subtable = toml_table_in(table, path.key))
+        walk(object, keys, subtable, &path);
+    else
+        report_type(path);
+}
 
-    // false if no config file
-    if (!config_file) {
-        notify_send("Config", "Could not parse config file, %s",
-                    config_file.error.c_str());
-        return false;
+// arrays of strings
+template <auto member>
+static void strings(member_owner<member> &object, const toml_table_t *table,
+                    const KeyPath &path) {
+    const toml_array_t *array = toml_array_in(table, path.key);
+    if (!array) {
+        report_type(path);
+        return;
     }
 
-    const toml::Table *root = config_file.table.get();
+    std::vector<std::string> &out = object.*member;
+    out.clear();
 
-    // get startup table
-    if (const toml::Table *startup = root->getTable("startup")) {
-        // startup commands
-        if (const toml::Array *exec = startup->getArray("exec")) {
-            auto commands = exec->getStringVector();
-            startup_commands.clear();
-            startup_commands = std::move(commands);
-        }
+    std::string string;
+    for (int i = 0; i != toml_array_nelem(array); ++i)
+        if (toml::read(array, i, string))
+            out.push_back(string);
+}
 
-        // env vars
-        if (const toml::Array *env = startup->getArray("env")) {
-            auto tables = env->getTableVector();
-            startup_env.clear();
-
-            for (const toml::Table *table : tables) {
-                auto keys = table->keys();
-
-                for (const std::string &key : keys) {
-                    // try both string and int values
-                    if (auto intval = table->getInt(key)) {
-                        startup_env.emplace_back(key, std::to_string(*intval));
-                    } else if (auto stringval = table->getString(key)) {
-                        startup_env.emplace_back(key, *stringval);
-                    }
-                }
-            }
-        }
-    } else {
-        startup_env.clear();
-        startup_commands.clear();
+// call fn with each table of an array of tables
+template <typename F>
+static void each_table(const toml_table_t *table, const KeyPath &path, F fn) {
+    const toml_array_t *array = toml_array_in(table, path.key);
+    if (!array) {
+        report_type(path);
+        return;
     }
 
-    // exit
-    if (const toml::Table *exit_table = root->getTable("exit")) {
-        // list of commands to run on exit
-        if (const toml::Array *exec = exit_table->getArray("exec")) {
-            auto commands = exec->getStringVector();
-            exit_commands.clear();
-            exit_commands = std::move(commands);
+    for (int i = 0; const toml_table_t *element = toml_table_at(array, i); ++i)
+        fn(element);
+}
+
+// startup
+static void startup_env(Config &config, const toml_table_t *table,
+                        const KeyPath &path) {
+    config.startup_env.clear();
+
+    each_table(table, path, [&](const toml_table_t *env) {
+        for (int i = 0; const char *key = toml_key_in(env, i); ++i) {
+            // try both string and int values
+            int64_t intval;
+            std::string stringval;
+            if (toml::read(env, key, intval))
+                config.startup_env.emplace_back(key, std::to_string(intval));
+            else if (toml::read(env, key, stringval))
+                config.startup_env.emplace_back(key, stringval);
         }
-    } else {
-        exit_commands.clear();
+    });
+}
+
+static constexpr Key<Config> startup_keys[] = {
+    {"exec", strings<&Config::startup_commands>},
+    {"env", startup_env},
+};
+
+static constexpr Key<Config> exit_keys[] = {
+    {"exec", strings<&Config::exit_commands>},
+};
+
+// ipc
+using Ipc = decltype(Config::ipc);
+
+static constexpr Key<Ipc> ipc_keys[] = {
+    {"socket", value<&Ipc::path>},
+    {"enabled", value<&Ipc::enabled>},
+    {"spawn", value<&Ipc::spawn>},
+    {"bind_run", value<&Ipc::bind_run>},
+};
+
+// keyboard
+static constexpr Key<Config> keyboard_keys[] = {
+    {"layout", value<&Config::keyboard_layout>},
+    {"model", value<&Config::keyboard_model>},
+    {"variant", value<&Config::keyboard_variant>},
+    {"options", value<&Config::keyboard_options>},
+    {"repeat_rate", value<&Config::repeat_rate>},
+    {"repeat_delay", value<&Config::repeat_delay>},
+};
+
+// pointer
+using Pointer = decltype(Config::cursor);
+using XCursor = decltype(Pointer::xcursor);
+using Mouse = decltype(Pointer::mouse);
+using Touchpad = decltype(Pointer::touchpad);
+
+static constexpr Choice<libinput_config_accel_profile> accel_profiles[] = {
+    {"none", LIBINPUT_CONFIG_ACCEL_PROFILE_NONE},
+    {"flat", LIBINPUT_CONFIG_ACCEL_PROFILE_FLAT},
+    {"adaptive", LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE},
+};
+
+static constexpr Choice<libinput_config_drag_lock_state> drag_locks[] = {
+    {"none", LIBINPUT_CONFIG_DRAG_LOCK_DISABLED},
+    {"timeout", LIBINPUT_CONFIG_DRAG_LOCK_ENABLED_TIMEOUT},
+    {"sticky", LIBINPUT_CONFIG_DRAG_LOCK_ENABLED_STICKY},
+};
+
+static constexpr Choice<libinput_config_tap_button_map> tap_button_maps[] = {
+    {"lrm", LIBINPUT_CONFIG_TAP_MAP_LRM},
+    {"lmr", LIBINPUT_CONFIG_TAP_MAP_LMR},
+};
+
+static constexpr Choice<libinput_config_scroll_method> scroll_methods[] = {
+    {"none", LIBINPUT_CONFIG_SCROLL_NO_SCROLL},
+    {"2fg", LIBINPUT_CONFIG_SCROLL_2FG},
+    {"edge", LIBINPUT_CONFIG_SCROLL_EDGE},
+    {"button", LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN},
+};
+
+static constexpr Choice<libinput_config_click_method> click_methods[] = {
+    {"none", LIBINPUT_CONFIG_CLICK_METHOD_NONE},
+    {"buttonareas", LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS},
+    {"clickfinger", LIBINPUT_CONFIG_CLICK_METHOD_CLICKFINGER},
+};
+
+static constexpr Choice<int> event_modes[] = {
+    {"enabled", LIBINPUT_CONFIG_SEND_EVENTS_ENABLED},
+    {"disabled", LIBINPUT_CONFIG_SEND_EVENTS_DISABLED},
+    {"mousedisabled", LIBINPUT_CONFIG_SEND_EVENTS_DISABLED_ON_EXTERNAL_MOUSE},
+};
+
+static constexpr Key<XCursor> xcursor_keys[] = {
+    {"theme", value<&XCursor::theme>},
+    {"size", value<&XCursor::size>},
+};
+
+static constexpr Key<Mouse> mouse_keys[] = {
+    {"natural_scroll", value<&Mouse::natural_scroll>},
+    {"left_handed", value<&Mouse::left_handed>},
+    {"accel_speed", value<&Mouse::accel_speed>},
+    {"batch_motion", value<&Mouse::batch_motion>},
+    {"profile", choice<&Mouse::profile, accel_profiles>},
+};
+
+static constexpr Key<Touchpad> touchpad_keys[] = {
+    {"tap_to_click", value<&Touchpad::tap_to_click>},
+    {"tap_and_drag", value<&Touchpad::tap_and_drag>},
+    {"drag_lock", choice<&Touchpad::drag_lock, drag_locks>},
+    {"tap_button_map", choice<&Touchpad::tap_button_map, tap_button_maps>},
+    {"natural_scroll", value<&Touchpad::natural_scroll>},
+    {"disable_while_typing", value<&Touchpad::disable_while_typing>},
+    {"left_handed", value<&Touchpad::left_handed>},
+    {"middle_emulation", value<&Touchpad::middle_emulation>},
+    {"scroll_method", choice<&Touchpad::scroll_method, scroll_methods>},
+    {"click_method", choice<&Touchpad::click_method, click_methods>},
+    {"event_mode", choice<&Touchpad::event_mode, event_modes>},
+    {"profile", choice<&Touchpad::profile, accel_profiles>},
+    {"accel_speed", value<&Touchpad::accel_speed>},
+    {"batch_motion", value<&Touchpad::batch_motion>},
+};
+
+static constexpr Key<Pointer> pointer_keys[] = {
+    {"xcursor", section<&Pointer::xcursor, xcursor_keys>},
+    {"mouse", section<&Pointer::mouse, mouse_keys>},
+    {"touchpad", section<&Pointer::touchpad, touchpad_keys>},
+};
+
+// general
+using General = decltype(Config::general);
+
+static constexpr Choice<FocusOnWindowActivation> focus_on_activations[] = {
+    {"none", FOWA_NONE},
+    {"active", FOWA_ACTIVE},
+    {"any", FOWA_ANY},
+};
+
+static constexpr Key<General> general_keys[] = {
+    {"focus_on_hover", value<&General::focus_on_hover>},
+    {"focus_on_activation", choice<&General::fowa, focus_on_activations>},
+    {"system_bell", value<&General::system_bell>},
+    {"minimize_to_workspace", value<&General::minimize_to_workspace>},
+    {"decorations", value<&General::decorations>},
+    {"disable_decorations", value<&General::disable_decorations>},
+};
+
+// tiling
+using Tiling = decltype(Config::tiling);
+
+static constexpr Choice<TileMethod> tile_methods[] = {
+    {"none", TILE_NONE},     {"grid", TILE_GRID}, {"master", TILE_MASTER},
+    {"dwindle", TILE_DWINDLE}, {"bsp", TILE_BSP},
+};
+
+static constexpr Key<Tiling> tiling_keys[] = {
+    {"method", choice<&Tiling::method, tile_methods>},
+    {"auto_tile", value<&Tiling::auto_tile>},
+    {"float_on_min_size", value<&Tiling::float_on_min_size>},
+    {"float_on_max_size", value<&Tiling::float_on_max_size>},
+    {"float_on_both", value<&Tiling::float_on_both>},
+};
+
+// binds
+template <BindName name>
+static void key_bind(Config &config, const toml_table_t *table,
+                     const KeyPath &path) {
+    std::string definition;
+    if (!toml::read(table, path.key, definition)) {
+        report_type(path);
+        return;
     }
 
-    // ipc
-    if (const toml::Table *ipc_table = root->getTable("ipc")) {
-        ipc.path = ipc_table->get<std::string>("socket", "");
-        ipc.enabled = ipc_table->get<bool>("enabled", true);
-        ipc.spawn = ipc_table->get<bool>("spawn", true);
-        ipc.bind_run = ipc_table->get<bool>("bind_run", true);
-    } else {
-        ipc.path = "";
-        ipc.enabled = true;
-        ipc.spawn = true;
-        ipc.bind_run = true;
+    if (const Bind *bind = parse_bind(definition, name)) {
+        config.binds.emplace_back(*bind);
+        delete bind;
     }
+}
 
-    // get keyboard config
-    if (const toml::Table *keyboard = root->getTable("keyboard")) {
-        keyboard_layout = keyboard->get<std::string>("layout", "us");
-        keyboard_model = keyboard->get<std::string>("model", "");
-        keyboard_variant = keyboard->get<std::string>("variant", "");
-        keyboard_options = keyboard->get<std::string>("options", "");
-        repeat_rate = keyboard->get<int64_t>("repeat_rate", 25);
-        repeat_delay = keyboard->get<int64_t>("repeat_delay", 600);
-    } else {
-        keyboard_layout = "us";
-        keyboard_model = "";
-        keyboard_variant = "";
-        keyboard_options = "";
-        repeat_rate = 25;
-        repeat_delay = 600;
-
-        wlr_log(WLR_INFO, "%s",
-                "no keyboard configuration found, using us layout with default "
-                "settings");
+static constexpr Key<Config> swap_bind_keys[] = {
+    {"up", key_bind<BIND_WINDOW_SWAP_UP>},
+    {"down", key_bind<BIND_WINDOW_SWAP_DOWN>},
+    {"left", key_bind<BIND_WINDOW_SWAP_LEFT>},
+    {"right", key_bind<BIND_WINDOW_SWAP_RIGHT>},
+};
+
+static constexpr Key<Config> half_bind_keys[] = {
+    {"up", key_bind<BIND_WINDOW_HALF_UP>},
+    {"down", key_bind<BIND_WINDOW_HALF_DOWN>},
+    {"left", key_bind<BIND_WINDOW_HALF_LEFT>},
+    {"right", key_bind<BIND_WINDOW_HALF_RIGHT>},
+};
+
+static constexpr Key<Config> window_bind_keys[] = {
+    {"maximize", key_bind<BIND_WINDOW_MAXIMIZE>},
+    {"fullscreen", key_bind<BIND_WINDOW_FULLSCREEN>},
+    {"previous", key_bind<BIND_WINDOW_PREVIOUS>},
+    {"next", key_bind<BIND_WINDOW_NEXT>},
+    {"move", key_bind<BIND_WINDOW_MOVE>},
+    {"resize", key_bind<BIND_WINDOW_RESIZE>},
+    {"pin", key_bind<BIND_WINDOW_PIN>},
+    {"toggle_floating", key_bind<BIND_WINDOW_TOGGLE_FLOATING>},
+    {"up", key_bind<BIND_WINDOW_UP>},
+    {"down", key_bind<BIND_WINDOW_DOWN>},
+    {"left", key_bind<BIND_WINDOW_LEFT>},
+    {"right", key_bind<BIND_WINDOW_RIGHT>},
+    {"close", key_bind<BIND_WINDOW_CLOSE>},
+    {"swap", flat<swap_bind_keys>},
+    {"half", flat<half_bind_keys>},
+};
+
+static constexpr Key<Config> workspace_bind_keys[] = {
+    {"tile", key_bind<BIND_WORKSPACE_TILE>},
+    {"tile_sans", key_bind<BIND_WORKSPACE_TILE_SANS>},
+    {"auto_tile", key_bind<BIND_WORKSPACE_AUTO_TILE>},
+    {"open", key_bind<BIND_WORKSPACE_OPEN>},
+    {"window_to", key_bind<BIND_WORKSPACE_WINDOW_TO>},
+};
+
+static constexpr Key<Config> bind_keys[] = {
+    {"exit", key_bind<BIND_EXIT>},
+    {"window", flat<window_bind_keys>},
+    {"workspace", flat<workspace_bind_keys>},
+};
+
+static void bind_section(Config &config, const toml_table_t *table,
+                         const KeyPath &path) {
+    const toml_table_t *binds_table = toml_table_in(table, path.key);
+    if (!binds_table) {
+        report_type(path);
+        return;
     }
 
-    // get pointer config
-    if (const toml::Table *pointer = root->getTable("pointer")) {
-        // xcursor
-        if (const toml::Table *xcursor_table = pointer->getTable("xcursor")) {
-            cursor.xcursor.theme = xcursor_table->get<std::string>("theme", "");
-            cursor.xcursor.size = xcursor_table->get<int64_t>("size", 24);
-        }
+    config.binds.clear();
+    walk(config, bind_keys, binds_table, &path);
 
-        // mouse
-        if (const toml::Table *mouse = pointer->getTable("mouse")) {
-            cursor.mouse.natural_scroll =
-                mouse->get<bool>("natural_scroll", false);
-            cursor.mouse.left_handed = mouse->get<bool>("left_handed", false);
-            cursor.mouse.accel_speed = mouse->get<double>("accel_speed", 0.0);
-
-            // profile
-            static const std::unordered_map<std::string,
-                                            libinput_config_accel_profile>
-                profile_map = {
-                    {"none", LIBINPUT_CONFIG_ACCEL_PROFILE_NONE},
-                    {"flat", LIBINPUT_CONFIG_ACCEL_PROFILE_FLAT},
-                    {"adaptive", LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE},
-                };
-            cursor.mouse.profile =
-                map_option("pointer.mouse.profile", profile_map,
-                           mouse->getString("profile"))
-                    .value_or(LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE);
-        }
+    // ensure exit bind is available
+    if (std::none_of(config.binds.begin(), config.binds.end(),
+                     [](const Bind &bind) { return bind.name == BIND_EXIT; })) {
+        config.binds.insert(config.binds.begin(),
+                            Bind{BIND_EXIT, WLR_MODIFIER_ALT, XKB_KEY_Escape});
+        notify_send("Config", "%s",
+                    "No exit bind set, press Alt+Escape to exit awm");
+    }
+}
 
-        // touchpad
-        if (const toml::Table *touchpad = pointer->getTable("touchpad")) {
-            // tap to click
-            if (auto tap_to_click = touchpad->getBool("tap_to_click")) {
-                cursor.touchpad.tap_to_click =
-                    static_cast<libinput_config_tap_state>(*tap_to_click);
-            }
+// user-defined commands
+struct CommandTable {
+    std::string bind, exec;
+};
 
-            // tap and drag
-            if (auto tap_and_drag = touchpad->getBool("tap_and_drag")) {
-                cursor.touchpad.tap_and_drag =
-                    static_cast<libinput_config_drag_state>(*tap_and_drag);
-            }
+static constexpr Key<CommandTable> command_keys[] = {
+    {"bind", value<&CommandTable::bind>},
+    {"exec", value<&CommandTable::exec>},
+};
 
-            // drag lock
-            static const std::unordered_map<std::string,
-                                            libinput_config_drag_lock_state>
-                drag_lock_map = {
-                    {"none", LIBINPUT_CONFIG_DRAG_LOCK_DISABLED},
-                    {"timeout", LIBINPUT_CONFIG_DRAG_LOCK_ENABLED_TIMEOUT},
-                    {"sticky", LIBINPUT_CONFIG_DRAG_LOCK_ENABLED_STICKY},
-                };
-            cursor.touchpad.drag_lock =
-                map_option("pointer.touchpad.drag_lock", drag_lock_map,
-                           touchpad->getString("drag_lock"))
-                    .value_or(LIBINPUT_CONFIG_DRAG_LOCK_ENABLED_STICKY);
-
-            // tap button map
-            static const std::unordered_map<std::string,
-                                            libinput_config_tap_button_map>
-                tap_button_map_map = {
-                    {"lrm", LIBINPUT_CONFIG_TAP_MAP_LRM},
-                    {"lmr", LIBINPUT_CONFIG_TAP_MAP_LMR},
-                };
-            cursor.touchpad.tap_button_map =
-                map_option("pointer.touchpad.tap_button_map",
-                           tap_button_map_map,
-                           touchpad->getString("tap_button_map"))
-                    .value_or(LIBINPUT_CONFIG_TAP_MAP_LRM);
-
-            cursor.touchpad.natural_scroll =
-                touchpad->get<bool>("natural_scroll", true);
-
-            // disable while typing
-            if (auto disable_while_typing =
-                    touchpad->getBool("disable_while_typing")) {
-                cursor.touchpad.disable_while_typing =
-                    static_cast<libinput_config_dwt_state>(
-                        *disable_while_typing);
-            }
+static void command_tables(Config &config, const toml_table_t *table,
+                           const KeyPath &path) {
+    config.commands.clear();
 
-            cursor.touchpad.left_handed =
-                touchpad->get<bool>("left_handed", false);
+    each_table(table, path, [&](const toml_table_t *command_table) {
+        CommandTable command;
+        walk(command, command_keys, command_table, &path);
 
-            // middle emulation
-            if (auto middle_emulation = touchpad->getBool("middle_emulation")) {
-                cursor.touchpad.middle_emulation =
-                    static_cast<libinput_config_middle_emulation_state>(
-                        *middle_emulation);
-            }
+        if (command.bind.empty() || command.exec.empty())
+            return;
 
-            // scroll method
-            static const std::unordered_map<std::string,
-                                            libinput_config_scroll_method>
-                scroll_method_map = {
-                    {"none", LIBINPUT_CONFIG_SCROLL_NO_SCROLL},
-                    {"2fg", LIBINPUT_CONFIG_SCROLL_2FG},
-                    {"edge", LIBINPUT_CONFIG_SCROLL_EDGE},
-                    {"button", LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN},
-                };
-            cursor.touchpad.scroll_method =
-                map_option("pointer.touchpad.scroll_method", scroll_method_map,
-                           touchpad->getString("scroll_method"))
-                    .value_or(LIBINPUT_CONFIG_SCROLL_2FG);
-
-            // click method
-            static const std::unordered_map<std::string,
-                                            libinput_config_click_method>
-                click_method_map = {
-                    {"none", LIBINPUT_CONFIG_CLICK_METHOD_NONE},
-                    {"buttonareas", LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS},
-                    {"clickfinger", LIBINPUT_CONFIG_CLICK_METHOD_CLICKFINGER},
-                };
-            cursor.touchpad.click_method =
-                map_option("pointer.touchpad.click_method", click_method_map,
-                           touchpad->getString("click_method"))
-                    .value_or(LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS);
-
-            // event mode
-            static const std::unordered_map<std::string, int> event_mode_map = {
-                {"enabled", LIBINPUT_CONFIG_SEND_EVENTS_ENABLED},
-                {"disabled", LIBINPUT_CONFIG_SEND_EVENTS_DISABLED},
-                {"mousedisabled",
-                 LIBINPUT_CONFIG_SEND_EVENTS_DISABLED_ON_EXTERNAL_MOUSE},
-            };
-            cursor.touchpad.event_mode =
-                map_option("pointer.touchpad.event_mode", event_mode_map,
-                           touchpad->getString("event_mode"))
-                    .value_or(LIBINPUT_CONFIG_SEND_EVENTS_ENABLED);
-
-            // profile
-            static const std::unordered_map<std::string,
-                                            libinput_config_accel_profile>
-                profile_map = {
-                    {"none", LIBINPUT_CONFIG_ACCEL_PROFILE_NONE},
-                    {"flat", LIBINPUT_CONFIG_ACCEL_PROFILE_FLAT},
-                    {"adaptive", LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE},
-                };
-            cursor.touchpad.profile =
-                map_option("pointer.touchpad.profile", profile_map,
-                           touchpad->getString("profile"))
-                    .value_or(LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE);
-
-            cursor.touchpad.accel_speed =
-                touchpad->get<double>("accel_speed", 0.0);
+        if (Bind *parsed = parse_bind(command.bind, BIND_NONE)) {
+            config.commands.emplace_back(*parsed, command.exec);
+            delete parsed;
         }
-    } else {
-        cursor.xcursor.theme = "";
-        cursor.xcursor.size = 24;
-
-        cursor.mouse.profile = LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE;
-        cursor.mouse.accel_speed = 0.0;
-        cursor.mouse.natural_scroll = false;
-        cursor.mouse.left_handed = false;
-
-        cursor.touchpad.tap_to_click = LIBINPUT_CONFIG_TAP_ENABLED;
-        cursor.touchpad.tap_and_drag = LIBINPUT_CONFIG_DRAG_ENABLED;
-        cursor.touchpad.drag_lock = LIBINPUT_CONFIG_DRAG_LOCK_ENABLED_STICKY;
-        cursor.touchpad.tap_button_map = LIBINPUT_CONFIG_TAP_MAP_LRM;
-        cursor.touchpad.natural_scroll = true;
-        cursor.touchpad.disable_while_typing = LIBINPUT_CONFIG_DWT_ENABLED;
-        cursor.touchpad.left_handed = false;
-        cursor.touchpad.middle_emulation =
-            LIBINPUT_CONFIG_MIDDLE_EMULATION_DISABLED;
-        cursor.touchpad.scroll_method = LIBINPUT_CONFIG_SCROLL_2FG;
-        cursor.touchpad.click_method =
-            LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS;
-        cursor.touchpad.event_mode = LIBINPUT_CONFIG_SEND_EVENTS_ENABLED;
-        cursor.touchpad.profile = LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE;
-        cursor.touchpad.accel_speed = 0.0;
-
-        wlr_log(WLR_INFO, "%s",
-                "no cursor configuration found, using defaults");
-    }
-
-    // general
-    if (const toml::Table *general_table = root->getTable("general")) {
-        general.focus_on_hover =
-            general_table->get<bool>("focus_on_hover", false);
-
-        // focus on activation
-        static const std::unordered_map<std::string, FocusOnWindowActivation>
-            fowa_map = {
-                {"none", FOWA_NONE},
-                {"active", FOWA_ACTIVE},
-                {"any", FOWA_ANY},
-            };
-        general.fowa =
-            map_option("general.focus_on_activation", fowa_map,
-                       general_table->getString("focus_on_activation"))
-                .value_or(FOWA_ACTIVE);
-
-        general.system_bell =
-            general_table->get<std::string>("system_bell", "");
-        general.minimize_to_workspace =
-            general_table->get<int64_t>("minimize_to_workspace", 0);
-        general.decorations = general_table->get<bool>("decorations", true);
-        general.disable_decorations =
-            general_table->get<bool>("disable_decorations", false);
-    } else {
-        general.focus_on_hover = false;
-        general.fowa = FOWA_ACTIVE;
-        general.system_bell = "";
-        general.minimize_to_workspace = 0;
-        general.decorations = true;
-        general.disable_decorations = false;
-
-        wlr_log(WLR_INFO, "%s",
-                "no general configuration found, using defaults");
-    }
-
-    // tiling
-    if (const toml::Table *tiling_table = root->getTable("tiling")) {
-        // method
-        static const std::unordered_map<std::string, TileMethod> method_map = {
-            {"none", TILE_NONE},     {"grid", TILE_GRID},
-            {"master", TILE_MASTER}, {"dwindle", TILE_DWINDLE},
-            {"bsp", TILE_BSP},
-        };
-        tiling.method = map_option("tiling.method", method_map,
-                                   tiling_table->getString("method"))
-                            .value_or(TILE_GRID);
-
-        tiling.auto_tile = tiling_table->get<bool>("auto_tile", false);
-        tiling.float_on_min_size =
-            tiling_table->get<bool>("float_on_min_size", false);
-        tiling.float_on_max_size =
-            tiling_table->get<bool>("float_on_max_size", false);
-        tiling.float_on_both = tiling_table->get<bool>("float_on_both", false);
-    } else {
-        tiling.method = TILE_GRID;
-        tiling.auto_tile = false;
-        tiling.float_on_min_size = false;
-        tiling.float_on_max_size = false;
-        tiling.float_on_both = false;
-    }
+    });
+}
 
-    // get awm binds
-    if (const toml::Table *binds_table = root->getTable("binds")) {
-        // clear binds
-        binds.clear();
+// monitors
+static constexpr Choice<wl_output_transform> transforms[] = {
+    {"none", WL_OUTPUT_TRANSFORM_NORMAL},
+    {"90", WL_OUTPUT_TRANSFORM_90},
+    {"180", WL_OUTPUT_TRANSFORM_180},
+    {"270", WL_OUTPUT_TRANSFORM_270},
+    {"f", WL_OUTPUT_TRANSFORM_FLIPPED},
+    {"f90", WL_OUTPUT_TRANSFORM_FLIPPED_90},
+    {"f180", WL_OUTPUT_TRANSFORM_FLIPPED_180},
+    {"f270", WL_OUTPUT_TRANSFORM_FLIPPED_270},
+};
+
+static constexpr Choice<RenderBitDepth> render_bit_depths[] = {
+    {"none", RENDER_BIT_DEPTH_DEFAULT},
+    {"6", RENDER_BIT_DEPTH_6},
+    {"8", RENDER_BIT_DEPTH_8},
+    {"10", RENDER_BIT_DEPTH_10},
+};
+
+static constexpr Key<OutputConfig> monitor_keys[] = {
+    {"name", value<&OutputConfig::name>},
+    {"enabled", value<&OutputConfig::enabled>},
+    {"width", value<&OutputConfig::width>},
+    {"height", value<&OutputConfig::height>},
+    {"x", value<&OutputConfig::x>},
+    {"y", value<&OutputConfig::y>},
+    {"refresh", value<&OutputConfig::refresh>},
+    {"transform", choice<&OutputConfig::transform, transforms>},
+    {"scale", value<&OutputConfig::scale>},
+    {"adaptive", value<&OutputConfig::adaptive_sync>},
+    {"tearing", value<&OutputConfig::allow_tearing>},
+    {"render_bit_depth",
+     choice<&OutputConfig::render_bit_depth, render_bit_depths>},
+    {"hdr", value<&OutputConfig::hdr>},
+    {"max_render_time", value<&OutputConfig::max_render_time>},
+};
+
+static void monitor_tables(Config &config, const toml_table_t *table,
+                           const KeyPath &path) {
+    for (OutputConfig *output : config.outputs)
+        delete output;
+    config.outputs.clear();
 
-        // exit bind
-        set_bind("exit", binds_table, BIND_EXIT);
+    each_table(table, path, [&](const toml_table_t *monitor) {
+        // create new output config, hdr is on unless the monitor turns it off
+        auto *oc = new OutputConfig();
+        oc->hdr = true;
+        walk(*oc, monitor_keys, monitor, &path);
 
-        // ensure exit bind is available
-        if (binds.empty()) {
-            binds.push_back(Bind{BIND_EXIT, WLR_MODIFIER_ALT, XKB_KEY_Escape});
+        // add to output configs if enough values are set
+        if (oc->name.empty() || !oc->width || !oc->height ||
+            oc->refresh <= 0.0) {
             notify_send("Config", "%s",
-                        "No exit bind set, press Alt+Escape to exit awm");
+                        "monitor config is missing one of the required "
+                        "fields: name, width, height, refresh");
+            delete oc;
+        } else {
+            wlr_log(WLR_INFO, "added monitor config for %s: %dx%d@%.1f",
+                    oc->name.c_str(), oc->width, oc->height, oc->refresh);
+            config.outputs.emplace_back(oc);
         }
+    });
+}
 
-        // window binds
-        if (const toml::Table *window_bind = binds_table->getTable("window")) {
-            set_bind("maximize", window_bind, BIND_WINDOW_MAXIMIZE);
-            set_bind("fullscreen", window_bind, BIND_WINDOW_FULLSCREEN);
-            set_bind("previous", window_bind, BIND_WINDOW_PREVIOUS);
-            set_bind("next", window_bind, BIND_WINDOW_NEXT);
-            set_bind("move", window_bind, BIND_WINDOW_MOVE);
-            set_bind("resize", window_bind, BIND_WINDOW_RESIZE);
-            set_bind("pin", window_bind, BIND_WINDOW_PIN);
-            set_bind("toggle_floating", window_bind,
-                     BIND_WINDOW_TOGGLE_FLOATING);
-            set_bind("up", window_bind, BIND_WINDOW_UP);
-            set_bind("down", window_bind, BIND_WINDOW_DOWN);
-            set_bind("left", window_bind, BIND_WINDOW_LEFT);
-            set_bind("right", window_bind, BIND_WINDOW_RIGHT);
-            set_bind("close", window_bind, BIND_WINDOW_CLOSE);
-
-            // swap binds
-            if (const toml::Table *swap_bind = window_bind->getTable("swap")) {
-                set_bind("up", swap_bind, BIND_WINDOW_SWAP_UP);
-                set_bind("down", swap_bind, BIND_WINDOW_SWAP_DOWN);
-                set_bind("left", swap_bind, BIND_WINDOW_SWAP_LEFT);
-                set_bind("right", swap_bind, BIND_WINDOW_SWAP_RIGHT);
-            }
+// window rules
+static constexpr Choice<xdg_toplevel_state> toplevel_states[] = {
+    {"maximized", XDG_TOPLEVEL_STATE_MAXIMIZED},
+    {"fullscreen", XDG_TOPLEVEL_STATE_FULLSCREEN},
+};
+
+static constexpr Choice<TilingMode> tiling_modes[] = {
+    {"auto", TILING_MODE_AUTO},
+    {"floating", TILING_MODE_FLOATING},
+    {"tiling", TILING_MODE_TILING},
+};
+
+static constexpr Key<wlr_box> geometry_keys[] = {
+    {"x", value<&wlr_box::x>},
+    {"y", value<&wlr_box::y>},
+    {"width", value<&wlr_box::width>},
+    {"height", value<&wlr_box::height>},
+};
+
+// read when the rule is created
+static void rule_match(WindowRule &, const toml_table_t *, const KeyPath &) {}
+
+// read a title, class or tag to match, a value that is not a string is
+// reported instead of leaving the rule without it
+static bool read_match(const toml_table_t *table, const KeyPath &path,
+                       std::string &match) {
+    if (!toml_key_exists(table, path.key))
+        return false;
 
-            // half binds
-            if (const toml::Table *half_bind = window_bind->getTable("half")) {
-                set_bind("up", half_bind, BIND_WINDOW_HALF_UP);
-                set_bind("down", half_bind, BIND_WINDOW_HALF_DOWN);
-                set_bind("left", half_bind, BIND_WINDOW_HALF_LEFT);
-                set_bind("right", half_bind, BIND_WINDOW_HALF_RIGHT);
-            }
-        }
+    if (toml::read(table, path.key, match))
+        return true;
 
-        // workspace binds
-        if (const toml::Table *workspace_bind =
-                binds_table->getTable("workspace")) {
-            set_bind("tile", workspace_bind, BIND_WORKSPACE_TILE);
-            set_bind("tile_sans", workspace_bind, BIND_WORKSPACE_TILE_SANS);
-            set_bind("auto_tile", workspace_bind, BIND_WORKSPACE_AUTO_TILE);
-            set_bind("open", workspace_bind, BIND_WORKSPACE_OPEN);
-            set_bind("window_to", workspace_bind, BIND_WORKSPACE_WINDOW_TO);
-        }
+    report_type(path);
+    return false;
+}
+
+static void rule_state(WindowRule &rule, const toml_table_t *table,
+                       const KeyPath &path) {
+    xdg_toplevel_state state;
+    if (read_choice(toplevel_states, table, path, state)) {
+        delete rule.toplevel_state;
+        rule.toplevel_state = new xdg_toplevel_state(state);
     }
+}
 
-    // Get user-defined commands
-    if (const toml::Array *command_tables = root->getArray("commands")) {
-        commands.clear();
+static void rule_geometry(WindowRule &rule, const toml_table_t *table,
+                          const KeyPath &path) {
+    const toml_table_t *geometry = toml_table_in(table, path.key);
+    if (!geometry) {
+        report_type(path);
+        return;
+    }
 
-        auto tables = command_tables->getTableVector();
-        for (const toml::Table *table : tables) {
-            auto bind = table->getString("bind");
-            auto exec = table->getString("exec");
+    if (!rule.geometry)
+        rule.geometry = new wlr_box{};
+    walk(*rule.geometry, geometry_keys, geometry, &path);
+}
 
-            if (bind && exec) {
-                if (Bind *parsed = parse_bind(*bind, BIND_NONE)) {
-                    commands.emplace_back(*parsed, *exec);
-                    delete parsed;
-                }
-            }
+static constexpr Key<WindowRule> rule_keys[] = {
+    {"title", rule_match},
+    {"class", rule_match},
+    {"tag", rule_match},
+    {"workspace", value<&WindowRule::workspace>},
+    {"output", value<&WindowRule::output>},
+    {"state", rule_state},
+    {"pinned", value<&WindowRule::pinned>},
+    {"floating", value<&WindowRule::floating>},
+    {"tiling_mode", choice<&WindowRule::tiling_mode, tiling_modes>},
+    {"geometry", rule_geometry},
+};
+
+static void window_rule_tables(Config &config, const toml_table_t *table,
+                               const KeyPath &path) {
+    for (WindowRule *rule : config.window_rules)
+        delete rule;
+    config.window_rules.clear();
+
+    each_table(table, path, [&](const toml_table_t *rule_table) {
+        std::string title, class_, tag;
+        uint8_t present = 0;
+        if (read_match(rule_table, {&path, "title"}, title))
+            present |= WINDOW_RULE_TITLE;
+        if (read_match(rule_table, {&path, "class"}, class_))
+            present |= WINDOW_RULE_CLASS;
+        if (read_match(rule_table, {&path, "tag"}, tag))
+            present |= WINDOW_RULE_TAG;
+
+        if (!present) {
+            notify_send("Config", "%s",
+                        "windowrules must have title, class or tag");
+            return;
         }
-    } else {
-        wlr_log(WLR_INFO, "%s", "No user-defined commands set, ignoring");
-    }
 
-    // monitor configs
-    if (const toml::Array *monitor_tables = root->getArray("monitors")) {
-        outputs.clear();
-
-        auto tables = monitor_tables->getTableVector();
-        for (const toml::Table *table : tables) {
-            // create new output config
-            auto *oc = new OutputConfig();
-
-            oc->name = table->get<std::string>("name", "");
-            oc->enabled = table->get<bool>("enabled", true);
-            oc->width = static_cast<int32_t>(table->get<int64_t>("width", 0));
-            oc->height = static_cast<int32_t>(table->get<int64_t>("height", 0));
-
-            // x and y can be int or double
-            if (auto x_int = table->getInt("x"))
-                oc->x = static_cast<double>(*x_int);
-            else
-                oc->x = table->get<double>("x", 0.0);
-
-            if (auto y_int = table->getInt("y"))
-                oc->y = static_cast<double>(*y_int);
-            else
-                oc->y = table->get<double>("y", 0.0);
-
-            // refresh can be int or double
-            if (auto refresh_int = table->getInt("refresh"))
-                oc->refresh = static_cast<double>(*refresh_int);
-            else
-                oc->refresh = table->get<double>("refresh", 0.0);
-
-            // transform
-            static const std::unordered_map<std::string, wl_output_transform>
-                transform_map = {
-                    {"none", WL_OUTPUT_TRANSFORM_NORMAL},
-                    {"90", WL_OUTPUT_TRANSFORM_90},
-                    {"180", WL_OUTPUT_TRANSFORM_180},
-                    {"270", WL_OUTPUT_TRANSFORM_270},
-                    {"f", WL_OUTPUT_TRANSFORM_FLIPPED},
-                    {"f90", WL_OUTPUT_TRANSFORM_FLIPPED_90},
-                    {"f180", WL_OUTPUT_TRANSFORM_FLIPPED_180},
-                    {"f270", WL_OUTPUT_TRANSFORM_FLIPPED_270},
-                };
-            oc->transform = map_option("monitors.transform", transform_map,
-                                       table->getString("transform"))
-                                .value_or(WL_OUTPUT_TRANSFORM_NORMAL);
-
-            // scale can be int or double
-            if (auto scale_int = table->getInt("scale"))
-                oc->scale = static_cast<float>(*scale_int);
-            else
-                oc->scale =
-                    static_cast<float>(table->get<double>("scale", 1.0));
-
-            if (auto adaptive = table->getBool("adaptive"))
-                oc->adaptive_sync = *adaptive;
-
-            oc->allow_tearing = table->get<bool>("tearing", false);
-
-            // render bit depth
-            static const std::unordered_map<std::string, RenderBitDepth>
-                bit_depth_map = {
-                    {"none", RENDER_BIT_DEPTH_DEFAULT},
-                    {"6", RENDER_BIT_DEPTH_6},
-                    {"8", RENDER_BIT_DEPTH_8},
-                    {"10", RENDER_BIT_DEPTH_10},
-                };
-            oc->render_bit_depth =
-                map_option("monitors.render_bit_depth", bit_depth_map,
-                           table->getString("render_bit_depth"))
-                    .value_or(RENDER_BIT_DEPTH_DEFAULT);
-
-            oc->hdr = table->get<bool>("hdr", true);
-            oc->max_render_time = static_cast<uint32_t>(
-                table->get<int64_t>("max_render_time", 0));
-
-            // add to output configs if enough values are set
-            if (oc->name.empty() || !oc->width || !oc->height ||
-                oc->refresh <= 0.0) {
-                notify_send("Config", "%s",
-                            "monitor config is missing one of the required "
-                            "fields: name, width, height, refresh");
-                delete oc;
-            } else {
-                wlr_log(WLR_INFO, "added monitor config for %s: %dx%d@%.1f",
-                        oc->name.c_str(), oc->width, oc->height, oc->refresh);
-                outputs.emplace_back(oc);
-            }
-        }
-    }
+        // create new WindowRule, geometry is only set by a geometry table
+        WindowRule *rule = new WindowRule(title, class_, tag, present);
 
-    // window rule configs
-    if (const toml::Array *window_rule_tables = root->getArray("windowrules")) {
-        window_rules.clear();
+        walk(*rule, rule_keys, rule_table, &path);
+        config.window_rules.emplace_back(rule);
+    });
+}
 
-        auto tables = window_rule_tables->getTableVector();
-        for (const toml::Table *table : tables) {
-            auto title_result = table->getString("title");
-            auto class_result = table->getString("class");
-            auto tag_result = table->getString("tag");
+// top level tables
+static constexpr Key<Config> config_keys[] = {
+    {"startup", flat<startup_keys>},
+    {"exit", flat<exit_keys>},
+    {"ipc", section<&Config::ipc, ipc_keys>},
+    {"keyboard", flat<keyboard_keys>},
+    {"pointer", section<&Config::cursor, pointer_keys>},
+    {"general", section<&Config::general, general_keys>},
+    {"tiling", section<&Config::tiling, tiling_keys>},
+    {"binds", bind_section},
+    {"commands", command_tables},
+    {"monitors", monitor_tables},
+    {"windowrules", window_rule_tables},
+};
+
+Config::Config() : path("") {
+    binds = {Bind{BIND_EXIT, WLR_MODIFIER_ALT, XKB_KEY_Escape}};
+    compile_binds();
+    notify_send("Config", "%s",
+                "no config loaded, press Alt+Escape to exit awm");
+}
 
-            if (!(title_result || class_result || tag_result)) {
-                notify_send("Config", "%s",
-                            "windowrules must have title, class or tag");
-                continue;
-            }
+Config::Config(const std::string &path) : path(path) {
+    if (!read(path, source)) {
+        notify_send("Config", "Could not open config file %s", path.c_str());
+        return;
+    }
 
-            // create new WindowRule
-            WindowRule *w = new WindowRule(
-                title_result.value_or(""), class_result.value_or(""),
-                tag_result.value_or(""),
-                (title_result.has_value() ? 1 : 0) |
-                    (class_result.has_value() ? 2 : 0) |
-                    (tag_result.has_value() ? 4 : 0));
-
-            // workspace
-            if (auto workspace = table->getInt("workspace")) {
-                w->workspace = static_cast<int>(*workspace);
-            }
+    // load config at path
+    loaded = load();
+}
 
-            // output
-            if (auto output = table->getString("output")) {
-                w->output = *output;
-            }
+// load config from text already read from path
+Config::Config(const std::string &path, std::string source)
+    : path(path), source(std::move(source)) {
+    loaded = load();
+}
 
-            // state
-            if (auto state_source = table->getString("state")) {
-                w->toplevel_state = new xdg_toplevel_state;
-                static const std::unordered_map<std::string, xdg_toplevel_state>
-                    state_map = {
-                        {"maximized", XDG_TOPLEVEL_STATE_MAXIMIZED},
-                        {"fullscreen", XDG_TOPLEVEL_STATE_FULLSCREEN},
-                    };
-                if (auto state = map_option("windowrules.state", state_map,
-                                            state_source)) {
-                    *w->toplevel_state = *state;
-                }
-            }
+// read the whole file at path into source
+bool Config::read(const std::string &path, std::string &source) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
 
-            // toplevel pinned
-            if (auto pinned = table->getBool("pinned")) {
-                w->pinned = *pinned;
-            }
+    source.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+    return !file.bad();
+}
 
-            // toplevel floating
-            if (auto floating = table->getBool("floating")) {
-                w->floating = *floating;
-            }
+// load config from path
+bool Config::load() {
+    // parse the text read from the config file
+    toml::ParseResult config_file = toml::parse(source);
 
-            // tiling mode
-            if (auto tiling_mode = table->getString("tiling_mode")) {
-                static const std::unordered_map<std::string, TilingMode>
-                    tiling_mode_map = {
-                        {"auto", TILING_MODE_AUTO},
-                        {"floating", TILING_MODE_FLOATING},
-                        {"tiling", TILING_MODE_TILING},
-                    };
-                if (auto mode = map_option("windowrules.tiling_mode",
-                                           tiling_mode_map, tiling_mode))
-                    w->tiling_mode = *mode;
-            }
+    // false if no config file
+    if (!config_file) {
+        notify_send("Config", "Could not parse config file, %s",
+                    config_file.error.c_str());
+        return false;
+    }
 
-            // geometry
-            if (const toml::Table *geometry_table =
-                    table->getTable("geometry")) {
-                w->geometry->x =
-                    static_cast<int>(geometry_table->get<int64_t>("x", 0));
-                w->geometry->y =
-                    static_cast<int>(geometry_table->get<int64_t>("y", 0));
-                w->geometry->width =
-                    static_cast<int>(geometry_table->get<int64_t>("width", 0));
-                w->geometry->height =
-                    static_cast<int>(geometry_table->get<int64_t>("height", 0));
-            } else {
-                delete w->geometry;
-                w->geometry = nullptr;
-            }
+    // write each table straight into its fields
+    walk(*this, config_keys, config_file.table.get(), nullptr);
 
-            window_rules.emplace_back(w);
-        }
-    }
+    compile_binds();
+    rule_index.compile(window_rules);
 
     return true;
 }
 
-Config::~Config() {
-    for (auto *output : outputs)
-        delete output;
-
-    for (auto *rule : window_rules)
-        delete rule;
+static uint64_t bind_key(uint32_t modifiers, xkb_keysym_t sym) {
+    return static_cast<uint64_t>(modifiers) << 32 | sym;
 }
 
-void Config::update(const struct Server *server) {
-    // check if config file has been modified
-    if (!std::filesystem::exists(path))
-        return;
+// build the bind table, earlier binds win and compositor binds take
+// precedence over user-defined commands
+void Config::compile_binds() {
+    bind_table.clear();
+    bind_table.reserve((binds.size() + commands.size()) * 2);
 
-    const std::filesystem::file_time_type current_write_time =
-        std::filesystem::last_write_time(path);
+    auto add = [&](const Bind &bind, BindAction action) {
+        if (bind.sym != XKB_KEY_NoSymbol) {
+            bind_table.emplace(bind_key(bind.modifiers, bind.sym), action);
+            return;
+        }
 
-    if (current_write_time == last_write_time)
-        return;
+        // 0 is on the right of 9 so it makes more sense this way
+        for (int n = 1; n <= 10; ++n) {
+            action.n = n;
+            bind_table.emplace(
+                bind_key(bind.modifiers, XKB_KEY_0 + n % 10), action);
+        }
+    };
 
-    last_write_time = current_write_time;
+    for (const Bind &bind : binds)
+        add(bind, {bind.name, 1, -1});
 
-    wlr_log(WLR_INFO, "%s", "config file modified, reloading");
+    for (uint32_t i = 0; i != commands.size(); ++i)
+        add(commands[i].first, {BIND_NONE, 1, static_cast<int32_t>(i)});
+}
 
-    // reload config
-    load();
+// find the action bound to a key or button
+const BindAction *Config::find_bind(uint32_t modifiers,
+                                    xkb_keysym_t sym) const {
+    auto it = bind_table.find(bind_key(modifiers, sym));
+    return it == bind_table.end() ? nullptr : &it->second;
+}
 
-    // update keyboard and cursor config
-    const wlr_keyboard *wlr_keyboard =
-        wlr_seat_get_keyboard(server->seat->wlr_seat);
-    const auto *keyboard = reinterpret_cast<Keyboard *>(wlr_keyboard->data);
+Config::~Config() {
+    for (auto *output : outputs)
+        delete output;
 
-    keyboard->update_config();
-    server->cursor->reconfigure_all();
+    for (auto *rule : window_rules)
+        delete rule;
+}
 
-    notify_send("Config", "%s", "config reload complete");
+// sections that differ between this config and another one
+uint32_t Config::diff(const Config &other) const {
+    uint32_t changed = 0;
+
+    if (std::tie(keyboard_layout, keyboard_model, keyboard_variant,
+                 keyboard_options, repeat_rate, repeat_delay) !=
+        std::tie(other.keyboard_layout, other.keyboard_model,
+                 other.keyboard_variant, other.keyboard_options,
+                 other.repeat_rate, other.repeat_delay))
+        changed |= CONFIG_KEYBOARD;
+
+    const auto &mouse = cursor.mouse, &other_mouse = other.cursor.mouse;
+    const auto &touchpad = cursor.touchpad,
+               &other_touchpad = other.cursor.touchpad;
+    if (std::tie(mouse.profile, mouse.accel_speed, mouse.natural_scroll,
+                 mouse.left_handed, mouse.batch_motion) !=
+            std::tie(other_mouse.profile, other_mouse.accel_speed,
+                     other_mouse.natural_scroll, other_mouse.left_handed,
+                     other_mouse.batch_motion) ||
+        std::tie(touchpad.tap_to_click, touchpad.tap_and_drag,
+                 touchpad.drag_lock, touchpad.tap_button_map,
+                 touchpad.natural_scroll, touchpad.disable_while_typing,
+                 touchpad.left_handed, touchpad.middle_emulation,
+                 touchpad.scroll_method, touchpad.click_method,
+                 touchpad.event_mode, touchpad.profile, touchpad.accel_speed,
+                 touchpad.batch_motion) !=
+            std::tie(other_touchpad.tap_to_click, other_touchpad.tap_and_drag,
+                     other_touchpad.drag_lock, other_touchpad.tap_button_map,
+                     other_touchpad.natural_scroll,
+                     other_touchpad.disable_while_typing,
+                     other_touchpad.left_handed,
+                     other_touchpad.middle_emulation,
+                     other_touchpad.scroll_method, other_touchpad.click_method,
+                     other_touchpad.event_mode, other_touchpad.profile,
+                     other_touchpad.accel_speed, other_touchpad.batch_motion))
+        changed |= CONFIG_POINTER;
+
+    if (std::tie(cursor.xcursor.theme, cursor.xcursor.size) !=
+        std::tie(other.cursor.xcursor.theme, other.cursor.xcursor.size))
+        changed |= CONFIG_XCURSOR;
+
+    // outputs and rules are compared in order, reordering rules changes
+    // which one matches first
+    auto same = [](const auto &a, const auto &b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                          [](auto *x, auto *y) { return *x == *y; });
+    };
+
+    if (!same(outputs, other.outputs))
+        changed |= CONFIG_OUTPUTS;
+
+    if (!same(window_rules, other.window_rules))
+        changed |= CONFIG_RULES;
+
+    // bind equality only compares keys
+    auto same_bind = [](const Bind &a, const Bind &b) {
+        return a.name == b.name && a == b;
+    };
+    if (!std::equal(binds.begin(), binds.end(), other.binds.begin(),
+                    other.binds.end(), same_bind) ||
+        !std::equal(commands.begin(), commands.end(), other.commands.begin(),
+                    other.commands.end(),
+                    [&](const auto &a, const auto &b) {
+                        return same_bind(a.first, b.first) &&
+                               a.second == b.second;
+                    }))
+        changed |= CONFIG_BINDS;
+
+    if (std::tie(tiling.method, tiling.auto_tile, tiling.float_on_min_size,
+                 tiling.float_on_max_size, tiling.float_on_both) !=
+        std::tie(other.tiling.method, other.tiling.auto_tile,
+                 other.tiling.float_on_min_size, other.tiling.float_on_max_size,
+                 other.tiling.float_on_both))
+        changed |= CONFIG_TILING;
+
+    if (std::tie(general.focus_on_hover, general.fowa, general.system_bell,
+                 general.minimize_to_workspace, general.decorations,
+                 general.disable_decorations) !=
+        std::tie(other.general.focus_on_hover, other.general.fowa,
+                 other.general.system_bell,
+                 other.general.minimize_to_workspace,
+                 other.general.decorations, other.general.disable_decorations))
+        changed |= CONFIG_GENERAL;
+
+    return changed;
 }
@@ -11,7 +11,9 @@
 #include "Toplevel.h"
 #include "Workspace.h"
 #include "wlr.h"
+#include <cmath>
 #include <pixman.h>
+#include <utility>
 #include <wayland-util.h>
 
 Cursor::Cursor(Seat *seat) : server(seat->server), seat(seat->wlr_seat) {
@@ -19,15 +21,18 @@ Cursor::Cursor(Seat *seat) : server(seat->server), seat(seat->wlr_seat) {
     cursor = wlr_cursor_create();
     wlr_cursor_attach_output_layout(cursor, server->output_manager->layout);
 
-    // size
-    const int64_t size = server->config->cursor.xcursor.size;
-    const char *theme = server->config->cursor.xcursor.theme.empty()
-                            ? nullptr
-                            : server->config->cursor.xcursor.theme.data();
-    xcursor_manager = wlr_xcursor_manager_create(theme, size > 0 ? size : 24);
+    xcursor_manager = create_xcursor_manager();
 
     cursor_mode = CURSORMODE_PASSTHROUGH;
 
+    // hit cache
+    pixman_region32_init(&last_hit_region);
+    last_hit_destroy.notify = [](wl_listener *listener,
+                                 [[maybe_unused]] void *data) {
+        Cursor *cursor = wl_container_of(listener, cursor, last_hit_destroy);
+        cursor->invalidate_hit();
+    };
+
     // cursor shape manager
     wlr_cursor_shape_manager =
         wlr_cursor_shape_manager_v1_create(server->display, 1);
@@ -94,6 +99,9 @@ Cursor::Cursor(Seat *seat) : server(seat->server), seat(seat->wlr_seat) {
         Server *server = cursor->server;
         const auto *event = static_cast<wlr_pointer_button_event *>(data);
 
+        // the button belongs to wherever the pointer is now
+        cursor->flush_motion();
+
         // notify activity
         cursor->notify_activity();
 
@@ -109,34 +117,21 @@ Cursor::Cursor(Seat *seat) : server(seat->server), seat(seat->wlr_seat) {
             cursor->pressed_buttons &= ~(1 << (event->button - 272));
         } else {
             // handle cursor focus
-            double sx, sy;
-            wlr_surface *surface = nullptr;
-
-            // layer surface focus
-            LayerSurface *layer_surface = server->layer_surface_at(
-                cursor->cursor->x, cursor->cursor->y, &surface, &sx, &sy);
-            if (layer_surface && surface && surface->mapped)
-                layer_surface->handle_focus();
-
-            // toplevel focus
-            Toplevel *toplevel = server->toplevel_at(
-                cursor->cursor->x, cursor->cursor->y, &surface, &sx, &sy);
-            if (toplevel && surface && surface->mapped)
-                server->focused_output()->get_active()->focus_toplevel(
-                    toplevel);
-
-            wlr_scene_node *node =
-                wlr_scene_node_at(&server->scene->tree.node, cursor->cursor->x,
-                                  cursor->cursor->y, &sx, &sy);
-
-            // hit detect decoration of toplevel
-            if (!toplevel && node && node->type == WLR_SCENE_NODE_RECT) {
-                wlr_scene_rect *rect = wl_container_of(node, rect, node);
-                if (rect && rect->node.parent && rect->node.parent->node.data) {
-                    Decoration *decoration =
-                        static_cast<Decoration *>(rect->node.parent->node.data);
-                    if (decoration && decoration->toplevel)
-                        toplevel = decoration->toplevel;
+            const Hit hit = cursor->hit_at_cursor();
+            Toplevel *toplevel = nullptr;
+
+            if (hit.type == HIT_DECORATION)
+                toplevel = hit.toplevel;
+            else if (hit.surface && hit.surface->mapped) {
+                // layer surface focus
+                if (hit.type == HIT_LAYER_SURFACE)
+                    hit.layer_surface->handle_focus();
+
+                // toplevel focus
+                if (hit.type == HIT_TOPLEVEL) {
+                    toplevel = hit.toplevel;
+                    server->focused_output()->get_active()->focus_toplevel(
+                        toplevel);
                 }
             }
 
@@ -180,33 +175,21 @@ Cursor::Cursor(Seat *seat) : server(seat->server), seat(seat->wlr_seat) {
                 }
             }
 
-            if (!handled_edge_resize) {
-                while (node && node->type == WLR_SCENE_NODE_RECT) {
-                    wlr_scene_rect *rect = wl_container_of(node, rect, node);
-                    if (!rect)
-                        break;
-                    Decoration *decoration =
-                        static_cast<Decoration *>(rect->node.parent->node.data);
-                    if (!decoration)
-                        break;
-                    toplevel = decoration->toplevel;
-
-                    switch (decoration->get_part_from_node(node)) {
-                    case DecorationPart::TITLEBAR:
-                        toplevel->begin_interactive(CURSORMODE_MOVE, 0);
-                        break;
-                    case DecorationPart::CLOSE_BUTTON:
-                        toplevel->close();
-                        break;
-                    case DecorationPart::MAXIMIZE_BUTTON:
-                        toplevel->toggle_maximized();
-                        break;
-                    case DecorationPart::FULLSCREEN_BUTTON:
-                        toplevel->toggle_fullscreen();
-                        break;
-                    default:
-                        break;
-                    }
+            if (!handled_edge_resize && hit.type == HIT_DECORATION) {
+                switch (hit.decoration->get_part_from_node(hit.node)) {
+                case DecorationPart::TITLEBAR:
+                    toplevel->begin_interactive(CURSORMODE_MOVE, 0);
+                    break;
+                case DecorationPart::CLOSE_BUTTON:
+                    toplevel->close();
+                    break;
+                case DecorationPart::MAXIMIZE_BUTTON:
+                    toplevel->toggle_maximized();
+                    break;
+                case DecorationPart::FULLSCREEN_BUTTON:
+                    toplevel->toggle_fullscreen();
+                    break;
+                default:
                     break;
                 }
             }
@@ -234,6 +217,8 @@ Cursor::Cursor(Seat *seat) : server(seat->server), seat(seat->wlr_seat) {
         Cursor *cursor = wl_container_of(listener, cursor, axis);
         const auto *event = static_cast<wlr_pointer_axis_event *>(data);
 
+        cursor->flush_motion();
+
         // notify activity
         cursor->notify_activity();
 
@@ -248,6 +233,10 @@ Cursor::Cursor(Seat *seat) : server(seat->server), seat(seat->wlr_seat) {
     frame.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
         Cursor *cursor = wl_container_of(listener, cursor, frame);
 
+        // batched motion sends its own frame once processed
+        if (cursor->motion_idle)
+            return;
+
         // forward to seat
         wlr_seat_pointer_notify_frame(cursor->seat);
     };
@@ -394,6 +383,12 @@ Cursor::~Cursor() {
     wl_list_remove(&hold_begin.link);
     wl_list_remove(&hold_end.link);
 
+    if (motion_idle)
+        wl_event_source_remove(motion_idle);
+
+    invalidate_hit();
+    pixman_region32_fini(&last_hit_region);
+
     clear_swap_indicator();
     wlr_cursor_destroy(cursor);
     wlr_xcursor_manager_destroy(xcursor_manager);
@@ -421,6 +416,10 @@ void Cursor::reset_mode() {
             if (source_workspace && source_workspace != current_workspace &&
                 source_workspace->auto_tile && !source_workspace->bsp_tree)
                 source_workspace->tile();
+
+            // moves during the grab did not invalidate the spatial index
+            if (current_workspace)
+                current_workspace->geometry_changed();
         } else if (cursor_mode == CURSORMODE_RESIZE) {
             // BSP mode: ratios were already adjusted during interactive resize
             // Non-BSP mode: configure events were already sent during interactive resize
@@ -447,25 +446,15 @@ void Cursor::update_swap_indicator() {
     }
 
     // find highest non-dragged toplevel
-    Toplevel *target = nullptr;
-    Toplevel *toplevel, *tmp;
-    wl_list_for_each_safe(toplevel, tmp, &current_workspace->toplevels, link) {
-        if (toplevel == grabbed)
-            continue;
-        if (toplevel->fullscreen())
-            continue;
-
-        // prevent swapping between floating and tiled toplevels
-        if (toplevel->is_floating != grabbed->is_floating)
-            continue;
-
-        wlr_box geo = toplevel->geometry;
-        if (cursor->x >= geo.x && cursor->x < geo.x + geo.width &&
-            cursor->y >= geo.y && cursor->y < geo.y + geo.height) {
-            target = toplevel;
-            break;
-        }
-    }
+    Toplevel *target = current_workspace->spatial().at(
+        static_cast<int>(std::floor(cursor->x)),
+        static_cast<int>(std::floor(cursor->y)), [grabbed](Toplevel *toplevel) {
+            if (toplevel == grabbed || toplevel->fullscreen())
+                return false;
+
+            // prevent swapping between floating and tiled toplevels
+            return toplevel->is_floating == grabbed->is_floating;
+        });
 
     if (target != swap_target) {
         swap_target = target;
@@ -573,13 +562,40 @@ void Cursor::process_motion(uint32_t time, wlr_input_device *device, double dx,
         }
     }
 
+    // move cursor
+    wlr_cursor_move(cursor, device, dx, dy);
+
+    // defer the rest until every event of this wakeup has been read
+    if (time && batched_pointers.count(device)) {
+        pending_motion_time = time;
+        if (!motion_idle)
+            motion_idle = wl_event_loop_add_idle(
+                server->event_loop,
+                [](void *data) {
+                    Cursor *cursor = static_cast<Cursor *>(data);
+                    cursor->motion_idle = nullptr;
+                    cursor->process_cursor_motion(cursor->pending_motion_time);
+                    wlr_seat_pointer_notify_frame(cursor->seat);
+                },
+                this);
+        return;
+    }
+
+    // this motion supersedes any batched one
+    if (motion_idle) {
+        wl_event_source_remove(motion_idle);
+        motion_idle = nullptr;
+    }
+
+    process_cursor_motion(time);
+}
+
+// settle the cursor at its current position
+void Cursor::process_cursor_motion(uint32_t time) {
     // update drag icon position
     wlr_scene_node_set_position(&server->layers.drag_icon->node, cursor->x,
                                 cursor->y);
 
-    // move cursor
-    wlr_cursor_move(cursor, device, dx, dy);
-
     // notify activity
     notify_activity();
 
@@ -594,40 +610,152 @@ void Cursor::process_motion(uint32_t time, wlr_input_device *device, double dx,
     }
 
     // otherwise mode is passthrough
-    double sx, sy;
-    wlr_surface *surface = nullptr;
-
-    // get the toplevel under the cursor (if exists)
-    const Toplevel *toplevel =
-        server->toplevel_at(cursor->x, cursor->y, &surface, &sx, &sy);
-    if (toplevel && surface && surface->mapped) {
-        // connect the seat to the toplevel
-        wlr_seat_pointer_notify_enter(seat, surface, sx, sy);
-        wlr_seat_pointer_notify_motion(seat, time, sx, sy);
+    const Hit hit = hit_at_cursor();
+    if (hit.type != HIT_NONE && hit.surface && hit.surface->mapped) {
+        // connect the seat to the surface
+        wlr_seat_pointer_notify_enter(seat, hit.surface, hit.sx, hit.sy);
+        wlr_seat_pointer_notify_motion(seat, time, hit.sx, hit.sy);
 
         // focus on hover
-        if (server->config->general.focus_on_hover)
-            toplevel->focus();
+        if (server->config->general.focus_on_hover) {
+            if (hit.type == HIT_TOPLEVEL)
+                hit.toplevel->focus();
+            else if (hit.type == HIT_LAYER_SURFACE)
+                hit.layer_surface->handle_focus();
+        }
         return;
     }
 
-    // get the layer surface under the cursor (if exists)
-    LayerSurface *layer_surface =
-        server->layer_surface_at(cursor->x, cursor->y, &surface, &sx, &sy);
-    if (layer_surface && surface && surface->mapped) {
-        // connect the seat to the layer surface
-        wlr_seat_pointer_notify_enter(seat, surface, sx, sy);
-        wlr_seat_pointer_notify_motion(seat, time, sx, sy);
+    // set default cursor mode
+    wlr_cursor_set_xcursor(cursor, xcursor_manager, "default");
+    wlr_seat_pointer_clear_focus(seat);
+}
 
-        // focus on hover
-        if (server->config->general.focus_on_hover)
-            layer_surface->handle_focus();
+// process batched motion now, before events that depend on pointer focus
+void Cursor::flush_motion() {
+    if (!motion_idle)
         return;
+
+    wl_event_source_remove(motion_idle);
+    motion_idle = nullptr;
+
+    process_cursor_motion(pending_motion_time);
+    wlr_seat_pointer_notify_frame(seat);
+}
+
+// add the bounds of the enabled nodes of a subtree to region
+static void add_node_bounds(pixman_region32_t *region, wlr_scene_node *node,
+                            int x, int y) {
+    if (!node->enabled)
+        return;
+
+    x += node->x;
+    y += node->y;
+
+    switch (node->type) {
+    case WLR_SCENE_NODE_TREE: {
+        wlr_scene_tree *tree = wlr_scene_tree_from_node(node);
+        wlr_scene_node *child;
+        wl_list_for_each(child, &tree->children, link)
+            add_node_bounds(region, child, x, y);
+        break;
+    }
+    case WLR_SCENE_NODE_RECT: {
+        wlr_scene_rect *rect = wlr_scene_rect_from_node(node);
+        pixman_region32_union_rect(region, region, x, y, rect->width,
+                                   rect->height);
+        break;
     }
+    case WLR_SCENE_NODE_BUFFER: {
+        wlr_scene_buffer *buffer = wlr_scene_buffer_from_node(node);
+        int width = buffer->dst_width, height = buffer->dst_height;
+        if (!width && buffer->buffer) {
+            width = buffer->buffer->width;
+            height = buffer->buffer->height;
+            if (buffer->transform & WL_OUTPUT_TRANSFORM_90)
+                std::swap(width, height);
+        }
 
-    // set default cursor mode
-    wlr_cursor_set_xcursor(cursor, xcursor_manager, "default");
-    wlr_seat_pointer_clear_focus(seat);
+        pixman_region32_union_rect(region, region, x, y, width, height);
+        break;
+    }
+    }
+}
+
+// get what is under the cursor, motion that stays on the last hit surface
+// skips the scene traversal
+Hit Cursor::hit_at_cursor() {
+    const double x = cursor->x, y = cursor->y;
+
+    if (last_hit.surface && last_hit.surface->mapped &&
+        last_hit_serial == server->geometry_serial &&
+        pixman_region32_contains_point(&last_hit_region,
+                                       static_cast<int>(std::floor(x)),
+                                       static_cast<int>(std::floor(y)),
+                                       nullptr)) {
+        Hit hit = last_hit;
+        hit.sx = x - last_hit_x;
+        hit.sy = y - last_hit_y;
+        return hit;
+    }
+
+    invalidate_hit();
+
+    Hit hit = server->hit_test(x, y);
+    if (!hit.surface || hit.type == HIT_NONE)
+        return hit;
+
+    // cropped or clipped surfaces do not map input one to one, do not cache
+    wlr_scene_buffer *buffer = wlr_scene_buffer_from_node(hit.node);
+    if (!wlr_fbox_empty(&buffer->src_box))
+        return hit;
+
+    // the input region of the surface in layout coordinates
+    int lx, ly;
+    wlr_scene_node_coords(hit.node, &lx, &ly);
+    pixman_region32_intersect_rect(&last_hit_region,
+                                   &hit.surface->input_region, 0, 0,
+                                   buffer->dst_width, buffer->dst_height);
+    pixman_region32_translate(&last_hit_region, lx, ly);
+
+    // minus everything stacked above the surface
+    pixman_region32_t above;
+    pixman_region32_init(&above);
+    int px = lx - hit.node->x, py = ly - hit.node->y;
+    for (wlr_scene_node *node = hit.node; node->parent;
+         node = &node->parent->node) {
+        for (wl_list *link = node->link.next; link != &node->parent->children;
+             link = link->next) {
+            wlr_scene_node *sibling = wl_container_of(link, sibling, link);
+            add_node_bounds(&above, sibling, px, py);
+        }
+
+        px -= node->parent->node.x;
+        py -= node->parent->node.y;
+    }
+    pixman_region32_subtract(&last_hit_region, &last_hit_region, &above);
+    pixman_region32_fini(&above);
+
+    if (!pixman_region32_not_empty(&last_hit_region))
+        return hit;
+
+    last_hit = hit;
+    last_hit_x = x - hit.sx;
+    last_hit_y = y - hit.sy;
+    last_hit_serial = server->geometry_serial;
+    wl_signal_add(&hit.surface->events.destroy, &last_hit_destroy);
+
+    return hit;
+}
+
+// forget the last hit, the scene may have changed under the cursor
+void Cursor::invalidate_hit() {
+    if (!last_hit.surface)
+        return;
+
+    wl_list_remove(&last_hit_destroy.link);
+    last_hit = {};
+    pixman_region32_clear(&last_hit_region);
 }
 
 // move a toplevel
@@ -649,7 +777,8 @@ void Cursor::process_move() {
     // set the new position
     wlr_scene_node_set_position(&toplevel->scene_tree->node, new_x, new_y);
 
-    // update position
+    // update position, the grabbed toplevel is skipped by spatial queries so
+    // the index is only invalidated once the grab ends
     toplevel->geometry.x = new_x;
     toplevel->geometry.y = new_y;
 
@@ -770,7 +899,7 @@ void Cursor::process_resize() {
                                        new_width, new_height);
 #endif
 
-    toplevel->geometry = {new_x, new_y, new_width, new_height};
+    toplevel->set_geometry({new_x, new_y, new_width, new_height});
 
     if (toplevel->decoration)
         toplevel->decoration->update_titlebar(new_width);
@@ -891,10 +1020,19 @@ bool Cursor::is_touchpad(wlr_pointer *pointer) const {
 void Cursor::set_config(wlr_pointer *pointer) {
     const Config *config = server->config;
 
-    if (!wlr_input_device_is_libinput(&pointer->base))
+    if (!wlr_input_device_is_libinput(&pointer->base)) {
+        batched_pointers.erase(&pointer->base);
         return;
+    }
     libinput_device *device = wlr_libinput_get_device_handle(&pointer->base);
 
+    // motion batching
+    if (is_touchpad(pointer) ? config->cursor.touchpad.batch_motion
+                             : config->cursor.mouse.batch_motion)
+        batched_pointers.insert(&pointer->base);
+    else
+        batched_pointers.erase(&pointer->base);
+
     if (is_touchpad(pointer)) {
         // touchpad config
 
@@ -996,3 +1134,26 @@ void Cursor::reconfigure_all() {
     for (wlr_pointer *pointer : pointers)
         set_config(pointer);
 }
+
+// create an xcursor manager with the configured theme and size
+wlr_xcursor_manager *Cursor::create_xcursor_manager() const {
+    const int64_t size = server->config->cursor.xcursor.size;
+    const char *theme = server->config->cursor.xcursor.theme.empty()
+                            ? nullptr
+                            : server->config->cursor.xcursor.theme.data();
+    return wlr_xcursor_manager_create(theme, size > 0 ? size : 24);
+}
+
+// switch to the configured xcursor theme and size
+void Cursor::reload_xcursor() {
+    wlr_xcursor_manager *previous = xcursor_manager;
+    xcursor_manager = create_xcursor_manager();
+
+    // the cursor must let go of the old manager before it is destroyed
+    wlr_cursor_set_xcursor(cursor, xcursor_manager, "default");
+    wlr_xcursor_manager_destroy(previous);
+
+    // clients set their cursor again when the pointer re-enters them
+    invalidate_hit();
+    wlr_seat_pointer_clear_focus(seat);
+}
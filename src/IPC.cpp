@@ -381,6 +381,18 @@ std::string IPC::parse_command(const std::string &command, const int client_fd,
                 }
                 break;
             }
+            goto unknown;
+        case 'n': // notification
+            if (std::getline(ss, token, ' ')) {
+                switch (token[0]) {
+                case 'l': // notification list
+                    message = IPC_NOTIFICATION_LIST;
+                    break;
+                default:
+                    goto unknown;
+                }
+                break;
+            }
             [[fallthrough]];
         default:
         unknown:
@@ -397,11 +409,12 @@ std::string IPC::parse_command(const std::string &command, const int client_fd,
     }
 
     // return parsed command
-    return handle_command(message, data).dump();
+    return handle_command(message, data, client_fd).dump();
 }
 
 // handle an IPC message, return the response json
-json IPC::handle_command(const IPCMessage message, const std::string &data) {
+json IPC::handle_command(const IPCMessage message, const std::string &data,
+                         const int client_fd) {
     json j;
 
     switch (message) {
@@ -409,8 +422,19 @@ json IPC::handle_command(const IPCMessage message, const std::string &data) {
         server->exit();
         break;
     case IPC_SPAWN:
-        if (server->config->ipc.spawn)
-            server->spawn(data);
+        if (server->config->ipc.spawn) {
+            LaunchOptions options;
+            options.activation_token = true;
+
+            // run the command in the working directory of the client
+            ucred cred{};
+            socklen_t len = sizeof(cred);
+            if (client_fd >= 0 && !getsockopt(client_fd, SOL_SOCKET,
+                                              SO_PEERCRED, &cred, &len))
+                options.cwd = "/proc/" + std::to_string(cred.pid) + "/cwd";
+
+            server->spawn(data, options);
+        }
         break;
     case IPC_OUTPUT_LIST: {
         Output *output, *tmp;
@@ -638,7 +662,7 @@ json IPC::handle_command(const IPCMessage message, const std::string &data) {
             // try parsing an integer
             const uint32_t n = std::stoi(data);
 
-            if (n < 1 || n > 10)
+            if (n < 1 || n > WORKSPACE_COUNT)
                 throw std::invalid_argument("out of range");
 
             // set workspace
@@ -675,7 +699,7 @@ json IPC::handle_command(const IPCMessage message, const std::string &data) {
                 {"width", t->geometry.width},
                 {"height", t->geometry.height},
                 {"focused", t == w->active_toplevel},
-                {"hidden", t->hidden},
+                {"hidden", t->hidden || w->hidden},
                 {"maximized", t->maximized()},
                 {"fullscreen", t->fullscreen()},
                 {"is_floating", t->is_floating},
@@ -848,7 +872,7 @@ json IPC::handle_command(const IPCMessage message, const std::string &data) {
                 if (digit < 1 || digit > 10)
                     throw std::invalid_argument("out of range");
 
-                keysym = digit + XKB_KEY_0;
+                keysym = digit % 10 + XKB_KEY_0;
             } catch (std::invalid_argument &e) {
                 notify_send("IPC", "invalid number `%s`: %s", data.c_str(),
                             e.what());
@@ -956,6 +980,19 @@ json IPC::handle_command(const IPCMessage message, const std::string &data) {
 
         break;
     }
+    case IPC_NOTIFICATION_LIST: {
+        j = json::array();
+        if (!server->notifier)
+            break;
+
+        for (const Notification &n : server->notifier->recent)
+            j.push_back({{"id", n.id},
+                         {"title", sanitize_for_json(n.title)},
+                         {"message", sanitize_for_json(n.message)},
+                         {"count", n.count},
+                         {"time", n.time}});
+        break;
+    }
     case IPC_NONE:
     default:
         break;
@@ -1015,6 +1052,31 @@ void IPC::notify_clients(const std::vector<IPCMessage> &messages) {
         notify_clients(message);
 }
 
+// queue messages so repeated notifications in one loop iteration are only
+// sent once
+void IPC::notify_clients_later(const std::vector<IPCMessage> &messages) {
+    for (const IPCMessage &message : messages)
+        pending_messages |= 1u << message;
+
+    if (pending_messages_idle)
+        return;
+
+    pending_messages_idle = wl_event_loop_add_idle(
+        server->event_loop,
+        [](void *data) {
+            IPC *ipc = static_cast<IPC *>(data);
+            ipc->pending_messages_idle = nullptr;
+
+            uint32_t pending = ipc->pending_messages;
+            ipc->pending_messages = 0;
+
+            for (uint32_t m = 0; m <= IPC_NOTIFICATION_LIST; ++m)
+                if (pending & (1u << m))
+                    ipc->notify_clients(static_cast<IPCMessage>(m));
+        },
+        this);
+}
+
 void IPC::stop() {
     // close
     close(fd);
@@ -1028,5 +1090,8 @@ void IPC::stop() {
     if (source)
         wl_event_source_remove(source);
 
+    if (pending_messages_idle)
+        wl_event_source_remove(pending_messages_idle);
+
     delete this;
 }
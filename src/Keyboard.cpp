@@ -2,15 +2,13 @@
 #include "Config.h"
 #include "Cursor.h"
 #include "IPC.h"
+#include "KeymapCache.h"
 #include "Seat.h"
 #include "Server.h"
 #include "util.h"
 
 // update the keyboard config
 void Keyboard::update_config() const {
-    // create xkb context
-    xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-
     // get config
     Config *config = server->config;
 
@@ -23,24 +21,10 @@ void Keyboard::update_config() const {
         config->keyboard_options.data(),
     };
 
-    // keymap
-    xkb_keymap *keymap =
-        xkb_keymap_new_from_names(context, &names, XKB_KEYMAP_COMPILE_NO_FLAGS);
-    if (!keymap) {
-        notify_send(
-            "Config",
-            "failed to load keymap - layout: %s, model: %s, variant: %s",
-            names.layout, names.model, names.variant);
-
-        // load default keymap
-        keymap = xkb_keymap_new_from_names(context, nullptr,
-                                           XKB_KEYMAP_COMPILE_NO_FLAGS);
-    }
-
-    // set keymap
-    wlr_keyboard_set_keymap(wlr_keyboard, keymap);
-    xkb_keymap_unref(keymap);
-    xkb_context_unref(context);
+    // set keymap, names that are not compiled yet resolve to the keymap
+    // already in use until the new one is swapped in
+    if (xkb_keymap *keymap = server->keymap_cache->get(names))
+        set_keymap(keymap);
 
     // repeat info
     wlr_keyboard_set_repeat_info(wlr_keyboard, server->config->repeat_rate,
@@ -51,6 +35,19 @@ void Keyboard::update_config() const {
         server->ipc->notify_clients({IPC_KEYBOARD_LIST, IPC_DEVICE_CURRENT});
 }
 
+// switch to a compiled keymap
+void Keyboard::set_keymap(xkb_keymap *keymap) const {
+    if (keymap == wlr_keyboard->keymap)
+        return;
+
+    wlr_keyboard_set_keymap(wlr_keyboard, keymap);
+
+    // notify clients, batched when many keyboards switch at once
+    if (server->ipc)
+        server->ipc->notify_clients_later(
+            {IPC_KEYBOARD_LIST, IPC_DEVICE_CURRENT});
+}
+
 // get keysyms without modifiers applied
 uint32_t Keyboard::keysyms_raw(const xkb_keycode_t keycode,
                                const xkb_keysym_t **keysyms) const {
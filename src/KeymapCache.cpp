@@ -0,0 +1,227 @@
+#include "KeymapCache.h"
+#include "Keyboard.h"
+#include "Server.h"
+#include "util.h"
+#include <csignal>
+#include <sys/eventfd.h>
+
+// distinct keymaps kept before unused ones are dropped
+constexpr size_t KEYMAP_CACHE_SIZE = 8;
+
+static std::string keymap_key(const xkb_rule_names &names) {
+    std::string key;
+    for (const char *name : {names.rules, names.model, names.layout,
+                             names.variant, names.options})
+        key.append(name ? name : "").append(1, '\n');
+    return key;
+}
+
+static void notify_keymap_failed(const char *layout, const char *model,
+                                 const char *variant) {
+    notify_send("Config",
+                "failed to load keymap - layout: %s, model: %s, variant: %s",
+                layout, model, variant);
+}
+
+KeymapCache::KeymapCache(Server *server)
+    : server(server), context(xkb_context_new(XKB_CONTEXT_NO_FLAGS)) {
+    done_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    done_source = wl_event_loop_add_fd(
+        server->event_loop, done_fd, WL_EVENT_READABLE,
+        [](int fd, [[maybe_unused]] uint32_t mask, void *data) {
+            eventfd_t value;
+            eventfd_read(fd, &value);
+
+            static_cast<KeymapCache *>(data)->finish_jobs();
+            return 0;
+        },
+        this);
+}
+
+KeymapCache::~KeymapCache() {
+    // let the worker finish its current job
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cond.notify_one();
+        worker.join();
+    }
+
+    for (KeymapJob *job : queue)
+        delete job;
+
+    for (KeymapJob *job : done) {
+        if (job->keymap)
+            xkb_keymap_unref(job->keymap);
+        delete job;
+    }
+
+    wl_event_source_remove(done_source);
+    close(done_fd);
+
+    for (auto &[key, keymap] : keymaps)
+        xkb_keymap_unref(keymap);
+
+    if (current)
+        xkb_keymap_unref(current);
+
+    xkb_context_unref(context);
+}
+
+// get the keymap for names. a cached keymap is returned right away,
+// otherwise it is compiled on the worker thread and swapped into every
+// keyboard once ready, until then the current keymap is returned
+xkb_keymap *KeymapCache::get(const xkb_rule_names &names) {
+    std::string key = keymap_key(names);
+    wanted = key;
+
+    if (auto it = keymaps.find(key); it != keymaps.end()) {
+        set_current(it->second);
+        return current;
+    }
+
+    if (current) {
+        if (!compiling.count(key))
+            compile_async(std::move(key), names);
+        return current;
+    }
+
+    // nothing to fall back on yet, only happens for the first keyboard
+    xkb_keymap *keymap =
+        xkb_keymap_new_from_names(context, &names, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    if (!keymap) {
+        notify_keymap_failed(names.layout, names.model, names.variant);
+
+        // load default keymap, cached under the failing names so the
+        // error is not repeated for every keyboard
+        keymap = xkb_keymap_new_from_names(context, nullptr,
+                                           XKB_KEYMAP_COMPILE_NO_FLAGS);
+        if (!keymap)
+            return nullptr;
+    }
+
+    insert(std::move(key), keymap);
+    set_current(keymap);
+    return current;
+}
+
+void KeymapCache::set_current(xkb_keymap *keymap) {
+    if (keymap == current)
+        return;
+
+    xkb_keymap_ref(keymap);
+    if (current)
+        xkb_keymap_unref(current);
+    current = keymap;
+}
+
+// take ownership of a compiled keymap
+void KeymapCache::insert(std::string key, xkb_keymap *keymap) {
+    // keyboards and current hold their own references, so evicting is safe
+    if (keymaps.size() >= KEYMAP_CACHE_SIZE) {
+        for (auto &[cached_key, cached] : keymaps)
+            xkb_keymap_unref(cached);
+        keymaps.clear();
+    }
+
+    keymaps.emplace(std::move(key), keymap);
+}
+
+void KeymapCache::compile_async(std::string key, const xkb_rule_names &names) {
+    KeymapJob *job = new KeymapJob{
+        key,
+        names.model ? names.model : "",
+        names.layout ? names.layout : "",
+        names.variant ? names.variant : "",
+        names.options ? names.options : "",
+    };
+    compiling.insert(std::move(key));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(job);
+    }
+
+    // started on first use
+    if (!worker.joinable())
+        worker = std::thread(&KeymapCache::run_worker, this);
+    else
+        cond.notify_one();
+}
+
+// worker thread, compiles queued jobs. xkb reference counts are not atomic,
+// so every job gets a context of its own that only its keymap refers to once
+// the job is handed to the event loop
+void KeymapCache::run_worker() {
+    // signals are handled by the event loop
+    sigset_t mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cond.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping)
+            break;
+
+        KeymapJob *job = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        const xkb_rule_names names{
+            nullptr,
+            job->model.c_str(),
+            job->layout.c_str(),
+            job->variant.c_str(),
+            job->options.c_str(),
+        };
+        xkb_context *job_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+        job->keymap = xkb_keymap_new_from_names(job_context, &names,
+                                                XKB_KEYMAP_COMPILE_NO_FLAGS);
+        if (!job->keymap) {
+            job->failed = true;
+            job->keymap = xkb_keymap_new_from_names(
+                job_context, nullptr, XKB_KEYMAP_COMPILE_NO_FLAGS);
+        }
+        xkb_context_unref(job_context);
+
+        lock.lock();
+        done.push_back(job);
+        eventfd_write(done_fd, 1);
+    }
+}
+
+// on the event loop, cache finished keymaps and swap in the wanted one
+void KeymapCache::finish_jobs() {
+    std::vector<KeymapJob *> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.swap(done);
+    }
+
+    for (KeymapJob *job : jobs) {
+        compiling.erase(job->key);
+
+        if (job->failed)
+            notify_keymap_failed(job->layout.c_str(), job->model.c_str(),
+                                 job->variant.c_str());
+
+        if (job->keymap) {
+            const bool swap = job->key == wanted;
+            xkb_keymap *keymap = job->keymap;
+            insert(std::move(job->key), keymap);
+
+            if (swap) {
+                set_current(keymap);
+
+                Keyboard *keyboard, *tmp;
+                wl_list_for_each_safe(keyboard, tmp, &server->keyboards, link)
+                    keyboard->set_keymap(keymap);
+            }
+        }
+
+        delete job;
+    }
+}
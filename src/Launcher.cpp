@@ -0,0 +1,133 @@
+#include "Launcher.h"
+#include "ActivationToken.h"
+#include "Server.h"
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <spawn.h>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+pid_t spawn_process(const std::vector<std::string> &argv,
+                    const LaunchOptions &options) {
+    if (argv.empty())
+        return -1;
+
+    // the compositor's environment with the overrides replacing its entries
+    std::vector<std::string> env;
+    for (char **entry = environ; *entry; ++entry) {
+        const std::string_view name =
+            std::string_view(*entry).substr(0, std::strcspn(*entry, "="));
+        if (std::none_of(options.env.begin(), options.env.end(),
+                         [&](const auto &o) { return o.first == name; }))
+            env.emplace_back(*entry);
+    }
+    for (const auto &[name, value] : options.env)
+        env.push_back(name + "=" + value);
+
+    std::vector<char *> envp, args;
+    for (std::string &entry : env)
+        envp.push_back(entry.data());
+    envp.push_back(nullptr);
+    for (const std::string &arg : argv)
+        args.push_back(const_cast<char *>(arg.c_str()));
+    args.push_back(nullptr);
+
+    // the signals the compositor blocks for its signalfd are unblocked again
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (!options.cwd.empty())
+        posix_spawn_file_actions_addchdir_np(&actions, options.cwd.c_str());
+    if (options.stdin_fd >= 0)
+        posix_spawn_file_actions_adddup2(&actions, options.stdin_fd,
+                                         STDIN_FILENO);
+
+    // glibc starts the child with vfork semantics, the page tables of the
+    // compositor are shared until the exec instead of being copied
+    pid_t pid;
+    const int err = posix_spawnp(&pid, args[0], &actions, &attr, args.data(),
+                                 envp.data());
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    if (err) {
+        wlr_log(WLR_ERROR, "failed to start `%s`: %s", argv[0].c_str(),
+                strerror(err));
+        return -1;
+    }
+
+    return pid;
+}
+
+Launcher::Launcher(Server *server) : server(server) {}
+
+// run a command with sh
+pid_t Launcher::spawn(const std::string &command,
+                      const LaunchOptions &options) {
+    LaunchOptions launch = options;
+
+    // a token for the first window of the command, found again by pid at map
+    ActivationToken *token = nullptr;
+    if (options.activation_token) {
+        wlr_xdg_activation_token_v1 *wlr_token =
+            wlr_xdg_activation_token_v1_create(server->wlr_xdg_activation);
+        token = new ActivationToken(server, wlr_token);
+        token->had_focus = true;
+
+        launch.env.emplace_back("XDG_ACTIVATION_TOKEN", wlr_token->token);
+        launch.env.emplace_back("DESKTOP_STARTUP_ID", wlr_token->token);
+    }
+
+    pid_t pid = spawn_process({"/bin/sh", "-c", command}, launch);
+
+    // fall back to the compositor's directory if the requested one is gone
+    if (pid < 0 && !launch.cwd.empty()) {
+        launch.cwd.clear();
+        pid = spawn_process({"/bin/sh", "-c", command}, launch);
+    }
+
+    if (token) {
+        if (pid > 0) {
+            token->pid = pid;
+        } else {
+            wlr_xdg_activation_token_v1_destroy(token->token);
+            server->clean_activation_tokens();
+        }
+    }
+
+    if (pid > 0)
+        children.emplace(pid, command);
+
+    return pid;
+}
+
+// collect every exited child, called on SIGCHLD
+void Launcher::reap() {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        auto it = children.find(pid);
+        if (it == children.end())
+            continue;
+
+        if (WIFEXITED(status) && WEXITSTATUS(status))
+            wlr_log(WLR_DEBUG, "`%s` exited with status %d",
+                    it->second.c_str(), WEXITSTATUS(status));
+        else if (WIFSIGNALED(status))
+            wlr_log(WLR_DEBUG, "`%s` killed by signal %d", it->second.c_str(),
+                    WTERMSIG(status));
+
+        children.erase(it);
+    }
+}
@@ -39,6 +39,7 @@ LayerSurface::LayerSurface(Output *output,
         // rearrange layers and outputs
         output->arrange_layers();
         output->server->output_manager->arrange();
+        output->server->cursor->invalidate_hit();
 
         // handle focus
         if (layer_surface->current.keyboard_interactive &&
@@ -53,6 +54,7 @@ LayerSurface::LayerSurface(Output *output,
 
         // disable surface
         wlr_scene_node_set_enabled(&surface->scene_tree->node, false);
+        surface->output->server->cursor->invalidate_hit();
 
         // arrange layers
         surface->output->arrange_layers();
@@ -79,6 +81,7 @@ LayerSurface::LayerSurface(Output *output,
                 output->shell_layer(layer_surface->current.layer);
             wlr_scene_node_reparent(&surface->scene_layer_surface->tree->node,
                                     new_tree);
+            output->server->cursor->invalidate_hit();
             needs_arrange = true;
         }
 
@@ -117,6 +120,9 @@ LayerSurface::~LayerSurface() {
     wl_list_remove(&new_popup.link);
     wl_list_remove(&destroy.link);
 
+    // the surface may outlive its role
+    output->server->cursor->invalidate_hit();
+
     // rearrange on destroy
     output->arrange_layers();
 }
@@ -0,0 +1,202 @@
+#include "Layout.h"
+#include <algorithm>
+#include <cmath>
+
+namespace layout {
+
+template <>
+void arrange<TILE_GRID>(LayoutSpan<LayoutWindow> windows, const wlr_box &area,
+                        LayoutSpan<wlr_box> out) {
+    int count = windows.size;
+    if (!count)
+        return;
+
+    // calculate rows and cols from window count
+    int rows = std::round(std::sqrt(count));
+    int cols = (count + rows - 1) / rows;
+
+    // width and height is just the fraction of the area
+    int width = area.width / cols;
+    int height = area.height / rows;
+
+    // sort by row and column order
+    std::sort(windows.begin(), windows.end(),
+              [&](const LayoutWindow &a, const LayoutWindow &b) {
+                  int ar = height ? a.geometry.y / height : 0;
+                  int ac = width ? a.geometry.x / width : 0;
+                  int br = height ? b.geometry.y / height : 0;
+                  int bc = width ? b.geometry.x / width : 0;
+
+                  if (ar != br)
+                      return ar < br;
+                  if (ac != bc)
+                      return ac < bc;
+                  return a.index < b.index;
+              });
+
+    for (int i = 0; i != count; ++i) {
+        int row = i / cols;
+        int col = i % cols;
+
+        wlr_box &box = out[windows[i].index];
+        box = {area.x + col * width, area.y + row * height, width, height};
+
+        // stretch the last window to fill the remaining space
+        if (int cells = cols * rows; i == count - 1 && cells != count)
+            box.width *= 1 + cells - count;
+    }
+}
+
+template <>
+void arrange<TILE_MASTER>(LayoutSpan<LayoutWindow> windows,
+                          const wlr_box &area, LayoutSpan<wlr_box> out) {
+    int count = windows.size;
+    if (!count)
+        return;
+
+    // take up the full area
+    if (count == 1) {
+        out[windows[0].index] = area;
+        return;
+    }
+
+    int width = area.width / 2;
+    int height = area.height / (count - 1);
+
+    // the master is the window closest to the top left
+    LayoutWindow *master = std::min_element(
+        windows.begin(), windows.end(),
+        [](const LayoutWindow &a, const LayoutWindow &b) {
+            return a.geometry.x + a.geometry.y < b.geometry.x + b.geometry.y;
+        });
+    std::swap(*master, windows[0]);
+
+    out[windows[0].index] = {area.x, area.y, width, area.height};
+
+    // stack the rest by y
+    std::sort(windows.begin() + 1, windows.end(),
+              [](const LayoutWindow &a, const LayoutWindow &b) {
+                  if (a.geometry.y != b.geometry.y)
+                      return a.geometry.y < b.geometry.y;
+                  return a.index < b.index;
+              });
+
+    for (int i = 1; i != count; ++i)
+        out[windows[i].index] = {area.x + width, area.y + (i - 1) * height,
+                                 width, height};
+}
+
+template <>
+void arrange<TILE_DWINDLE>(LayoutSpan<LayoutWindow> windows,
+                           const wlr_box &area, LayoutSpan<wlr_box> out) {
+    int count = windows.size;
+    if (!count)
+        return;
+
+    // sort by sum of x and y
+    std::sort(windows.begin(), windows.end(),
+              [](const LayoutWindow &a, const LayoutWindow &b) {
+                  int as = a.geometry.x + a.geometry.y;
+                  int bs = b.geometry.x + b.geometry.y;
+                  if (as != bs)
+                      return as < bs;
+                  return a.index < b.index;
+              });
+
+    // start with the full area
+    int x = area.x;
+    int y = area.y;
+    int width = area.width;
+    int height = area.height;
+
+    // 1 window means that it should take up the full area
+    if (count != 1)
+        width /= 2;
+
+    for (int i = 0; i != count; ++i) {
+        out[windows[i].index] = {x, y, width, height};
+
+        if (i % 2) {
+            // do not change size for last window
+            if (i != count - 2)
+                width /= 2;
+            y += height;
+        } else {
+            // do not change size for last window
+            if (i != count - 2)
+                height /= 2;
+            x += width;
+        }
+    }
+}
+
+// same shape as a BSPTree built by inserting the windows one by one, the
+// first child always holds the larger half
+static void arrange_bsp(LayoutWindow *windows, size_t count, const wlr_box &box,
+                        int depth, wlr_box *out) {
+    if (count == 1) {
+        out[windows[0].index] = box;
+        return;
+    }
+
+    wlr_box first = box;
+    wlr_box second = box;
+
+    if (depth % 2 == 0) {
+        first.width = box.width / 2;
+        second.x = box.x + first.width;
+        second.width = box.width - first.width;
+    } else {
+        first.height = box.height / 2;
+        second.y = box.y + first.height;
+        second.height = box.height - first.height;
+    }
+
+    // windows closest to the start of the split go into the first child,
+    // which keeps the result stable when it is laid out again
+    size_t first_count = (count + 1) / 2;
+    bool horizontal = depth % 2 == 0;
+    std::nth_element(windows, windows + first_count, windows + count,
+                     [horizontal](const LayoutWindow &a, const LayoutWindow &b) {
+                         int ap = horizontal ? a.geometry.x : a.geometry.y;
+                         int bp = horizontal ? b.geometry.x : b.geometry.y;
+                         if (ap != bp)
+                             return ap < bp;
+                         return a.index < b.index;
+                     });
+
+    arrange_bsp(windows, first_count, first, depth + 1, out);
+    arrange_bsp(windows + first_count, count - first_count, second, depth + 1,
+                out);
+}
+
+template <>
+void arrange<TILE_BSP>(LayoutSpan<LayoutWindow> windows, const wlr_box &area,
+                       LayoutSpan<wlr_box> out) {
+    if (!windows.size)
+        return;
+
+    arrange_bsp(windows.data, windows.size, area, 0, out.data);
+}
+
+bool arrange(TileMethod method, LayoutSpan<LayoutWindow> windows,
+             const wlr_box &area, LayoutSpan<wlr_box> out) {
+    switch (method) {
+    case TILE_GRID:
+        arrange<TILE_GRID>(windows, area, out);
+        return true;
+    case TILE_MASTER:
+        arrange<TILE_MASTER>(windows, area, out);
+        return true;
+    case TILE_DWINDLE:
+        arrange<TILE_DWINDLE>(windows, area, out);
+        return true;
+    case TILE_BSP:
+        arrange<TILE_BSP>(windows, area, out);
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace layout
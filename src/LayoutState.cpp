@@ -0,0 +1,381 @@
+#include "LayoutState.h"
+#include "Config.h"
+#include "Output.h"
+#include "OutputManager.h"
+#include "Server.h"
+#include "Toplevel.h"
+#include "Workspace.h"
+#include "WorkspaceManager.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+constexpr int LAYOUT_SAVE_INTERVAL_MS = 60000;
+
+// unmatched windows are kept this many save intervals after startup
+constexpr uint32_t LAYOUT_RESTORE_TICKS = 5;
+
+static std::string window_key(std::string_view app_id, std::string_view title,
+                              std::string_view tag) {
+    std::string key;
+    key.reserve(app_id.size() + title.size() + tag.size() + 2);
+    key.append(app_id).append(1, '\n');
+    key.append(title).append(1, '\n');
+    key.append(tag);
+    return key;
+}
+
+static json shape_to_json(const BSPShape &shape) {
+    if (shape.split == SplitType::NONE)
+        return {{"window", shape.leaf}};
+
+    return {{"split", shape.split == SplitType::HORIZONTAL ? "h" : "v"},
+            {"ratio", shape.ratio},
+            {"children",
+             {shape_to_json(shape.children[0]),
+              shape_to_json(shape.children[1])}}};
+}
+
+static BSPShape shape_from_json(const json &j) {
+    BSPShape shape;
+    if (j.contains("window")) {
+        shape.leaf = j["window"].get<int>();
+        return shape;
+    }
+
+    const json &children = j.at("children");
+    if (children.size() != 2)
+        return shape;
+
+    shape.split = j.at("split").get<std::string>() == "h"
+                      ? SplitType::HORIZONTAL
+                      : SplitType::VERTICAL;
+    shape.ratio = j.value("ratio", 0.5f);
+    shape.children.push_back(shape_from_json(children[0]));
+    shape.children.push_back(shape_from_json(children[1]));
+    return shape;
+}
+
+LayoutState::LayoutState(Server *server)
+    : server(server), restore_ticks(LAYOUT_RESTORE_TICKS) {
+    // $XDG_STATE_HOME/awm/layout.json, falling back to ~/.local/state
+    if (const char *state = getenv("XDG_STATE_HOME"); state && *state)
+        path = std::string(state) + "/awm/layout.json";
+    else if (const char *home = getenv("HOME"))
+        path = std::string(home) + "/.local/state/awm/layout.json";
+
+    load();
+
+    save_timer = wl_event_loop_add_timer(
+        server->event_loop,
+        [](void *data) {
+            LayoutState *state = static_cast<LayoutState *>(data);
+
+            // stop waiting for windows that never came back
+            if (state->restore_ticks && !--state->restore_ticks)
+                state->forget();
+
+            state->save();
+
+            wl_event_source_timer_update(state->save_timer,
+                                         LAYOUT_SAVE_INTERVAL_MS);
+            return 0;
+        },
+        this);
+    wl_event_source_timer_update(save_timer, LAYOUT_SAVE_INTERVAL_MS);
+}
+
+LayoutState::~LayoutState() {
+    if (save_timer)
+        wl_event_source_remove(save_timer);
+}
+
+// read the snapshot written by a previous instance
+void LayoutState::load() {
+    if (path.empty())
+        return;
+
+    std::ifstream file(path);
+    if (!file)
+        return;
+
+    json j = json::parse(file, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) {
+        wlr_log(WLR_ERROR, "ignoring malformed layout state `%s`",
+                path.c_str());
+        return;
+    }
+
+    try {
+        for (const json &w : j.value("windows", json::array())) {
+            SavedWindow saved;
+            saved.app_id = w.value("app_id", "");
+            saved.title = w.value("title", "");
+            saved.tag = w.value("tag", "");
+            saved.output = w.value("output", "");
+            saved.workspace = w.value("workspace", 0u);
+            saved.floating = w.value("floating", false);
+
+            const json &geo = w.at("geometry");
+            saved.geometry = {geo.at(0).get<int>(), geo.at(1).get<int>(),
+                              geo.at(2).get<int>(), geo.at(3).get<int>()};
+
+            windows.push_back(std::move(saved));
+        }
+
+        for (const json &w : j.value("workspaces", json::array())) {
+            SavedWorkspace saved;
+            saved.output = w.value("output", "");
+            saved.num = w.value("num", 0u);
+            saved.auto_tile = w.value("auto_tile", false);
+            if (w.contains("tree"))
+                saved.tree = shape_from_json(w["tree"]);
+
+            workspaces.push_back(std::move(saved));
+        }
+
+        for (const auto &[output, num] :
+             j.value("active", json::object()).items())
+            active_workspaces[output] = num.get<uint32_t>();
+    } catch (const json::exception &e) {
+        wlr_log(WLR_ERROR, "ignoring malformed layout state `%s`: %s",
+                path.c_str(), e.what());
+        windows.clear();
+        workspaces.clear();
+        active_workspaces.clear();
+        return;
+    }
+
+    // index in reverse so the first saved window is matched first
+    for (uint32_t i = windows.size(); i-- > 0;) {
+        const SavedWindow &saved = windows[i];
+        if (saved.app_id.empty())
+            continue;
+
+        by_key[window_key(saved.app_id, saved.title, saved.tag)].push_back(i);
+        by_app_id[saved.app_id].push_back(i);
+    }
+
+    wlr_log(WLR_INFO, "loaded layout state with %zu windows from `%s`",
+            windows.size(), path.c_str());
+}
+
+// write the current layout if it changed since the last write
+void LayoutState::save() {
+    if (path.empty())
+        return;
+
+    // do not overwrite slots of windows that have not come back yet
+    if (!by_app_id.empty())
+        return;
+
+    json j;
+    json &saved_windows = j["windows"] = json::array();
+    json &saved_workspaces = j["workspaces"] = json::array();
+    json &active = j["active"] = json::object();
+
+    std::unordered_map<Toplevel *, int> ids;
+
+    Workspace *workspace, *tmp;
+    wl_list_for_each_safe(workspace, tmp, &server->workspace_manager->workspaces,
+                          link) {
+        if (!workspace->output)
+            continue;
+
+        const char *output = workspace->output->wlr_output->name;
+
+        // oldest toplevel first
+        Toplevel *toplevel;
+        wl_list_for_each_reverse(toplevel, &workspace->toplevels, link) {
+            const wlr_box &geo = toplevel->geometry;
+
+            ids[toplevel] = saved_windows.size();
+            saved_windows.push_back(
+                {{"app_id", std::string(toplevel->get_app_id())},
+                 {"title", std::string(toplevel->get_title())},
+                 {"tag", toplevel->tag},
+                 {"output", output},
+                 {"workspace", workspace->num},
+                 {"floating", toplevel->is_floating},
+                 {"geometry", {geo.x, geo.y, geo.width, geo.height}}});
+        }
+
+        json saved = {{"output", output},
+                      {"num", workspace->num},
+                      {"auto_tile", workspace->auto_tile}};
+        if (workspace->bsp_tree && workspace->bsp_tree->root)
+            saved["tree"] = shape_to_json(workspace->bsp_tree->save(
+                [&](Toplevel *toplevel) {
+                    auto it = ids.find(toplevel);
+                    return it == ids.end() ? -1 : it->second;
+                }));
+
+        saved_workspaces.push_back(std::move(saved));
+    }
+
+    Output *output, *tmp_output;
+    wl_list_for_each_safe(output, tmp_output, &server->output_manager->outputs,
+                          link) if (!output->workspaces.empty())
+        active[output->wlr_output->name] = output->active_workspace;
+
+    std::string data = j.dump();
+    if (data == last_saved)
+        return;
+
+    // write to a temporary file first so a crash cannot truncate the state
+    std::error_code ec;
+    std::filesystem::create_directories(
+        std::filesystem::path(path).parent_path(), ec);
+
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        if (!(file << data)) {
+            wlr_log(WLR_ERROR, "failed to write layout state to `%s`",
+                    tmp_path.c_str());
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        wlr_log(WLR_ERROR, "failed to write layout state to `%s`: %s",
+                path.c_str(), ec.message().c_str());
+        return;
+    }
+
+    last_saved = std::move(data);
+}
+
+// claim the saved slot of a newly mapped toplevel, if any
+SavedWindow *LayoutState::match(Toplevel *toplevel) {
+    if (by_app_id.empty())
+        return nullptr;
+
+    const std::string_view app_id = toplevel->get_app_id();
+    if (app_id.empty())
+        return nullptr;
+
+    auto take = [&](std::unordered_map<std::string, std::vector<uint32_t>> &map,
+                    const std::string &key) -> SavedWindow * {
+        auto it = map.find(key);
+        if (it == map.end())
+            return nullptr;
+
+        // skip slots already claimed through the other map
+        std::vector<uint32_t> &slots = it->second;
+        SavedWindow *saved = nullptr;
+        while (!saved && !slots.empty()) {
+            if (!windows[slots.back()].toplevel)
+                saved = &windows[slots.back()];
+            slots.pop_back();
+        }
+
+        if (slots.empty())
+            map.erase(it);
+
+        return saved;
+    };
+
+    SavedWindow *saved =
+        take(by_key, window_key(app_id, toplevel->get_title(), toplevel->tag));
+    if (!saved)
+        saved = take(by_app_id, std::string(app_id));
+    if (!saved)
+        return nullptr;
+
+    saved->toplevel = toplevel;
+
+    // drop the app_id index once every slot of an app has been claimed
+    if (auto it = by_app_id.find(saved->app_id); it != by_app_id.end()) {
+        std::vector<uint32_t> &slots = it->second;
+        while (!slots.empty() && windows[slots.back()].toplevel)
+            slots.pop_back();
+        if (slots.empty())
+            by_app_id.erase(it);
+    }
+
+    return saved;
+}
+
+// get the workspace a saved window belongs on, if its output is present
+Workspace *LayoutState::workspace_for(const SavedWindow *saved) const {
+    Output *output = server->output_manager->get_output(saved->output);
+    return output ? output->get_workspace(saved->workspace) : nullptr;
+}
+
+// add a matched toplevel to its workspace, tiled toplevels are placed into
+// their saved slot of the bsp tree before the workspace lays them out
+void LayoutState::restore(Toplevel *toplevel, SavedWindow *saved,
+                          Workspace *workspace) {
+    toplevel->is_floating = saved->floating;
+
+    TileMethod method = server->config->tiling.method;
+    if (!saved->floating && workspace->auto_tile && workspace->bsp_tree &&
+        (method == TILE_BSP || method == TILE_DWINDLE))
+        if (const SavedWorkspace *shape =
+                saved_workspace(saved->output, saved->workspace))
+            workspace->bsp_tree->restore(shape->tree, [&](int id) -> Toplevel * {
+                if (id < 0 || static_cast<size_t>(id) >= windows.size())
+                    return nullptr;
+
+                Toplevel *tl = windows[id].toplevel;
+                if (!tl || (tl != toplevel && !workspace->contains(tl)) ||
+                    tl->is_floating || tl->fullscreen())
+                    return nullptr;
+
+                return tl;
+            });
+
+    workspace->add_toplevel(toplevel,
+                            workspace == workspace->output->get_active());
+
+    // every saved window is back
+    if (by_app_id.empty())
+        forget();
+}
+
+// drop references to a toplevel that is going away
+void LayoutState::release(Toplevel *toplevel) {
+    for (SavedWindow &saved : windows)
+        if (saved.toplevel == toplevel)
+            saved.toplevel = nullptr;
+}
+
+// recreate the saved workspaces of an output that appeared for the first time
+void LayoutState::restore_output(Output *output) {
+    const std::string name = output->wlr_output->name;
+
+    for (const SavedWorkspace &saved : workspaces) {
+        if (saved.output != name)
+            continue;
+
+        Workspace *workspace = output->get_workspace(saved.num);
+        if (workspace && workspace->auto_tile != saved.auto_tile)
+            workspace->toggle_auto_tile();
+    }
+
+    if (auto it = active_workspaces.find(name); it != active_workspaces.end())
+        output->set_workspace(it->second);
+}
+
+const SavedWorkspace *LayoutState::saved_workspace(const std::string &output,
+                                                   uint32_t num) const {
+    for (const SavedWorkspace &saved : workspaces)
+        if (saved.num == num && saved.output == output)
+            return &saved;
+
+    return nullptr;
+}
+
+// stop matching windows against the snapshot
+void LayoutState::forget() {
+    by_key.clear();
+    by_app_id.clear();
+    windows.clear();
+    workspaces.clear();
+    active_workspaces.clear();
+}
@@ -0,0 +1,250 @@
+#include "Notifier.h"
+#include "IPC.h"
+#include "Launcher.h"
+#include "Server.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+// messages arriving within this are sent together
+constexpr int NOTIFY_BATCH_MS = 250;
+
+// an identical message is not sent to the desktop again within this
+constexpr int64_t NOTIFY_REPEAT_MS = 5000;
+
+// messages shown in one batched notification
+constexpr size_t NOTIFY_BATCH_LINES = 8;
+
+// notifications kept for IPC
+constexpr size_t NOTIFY_HISTORY = 32;
+
+// messages queued between two event loop iterations, the rest only go to
+// the log
+constexpr size_t NOTIFY_QUEUE_SIZE = 1024;
+
+// reads a title line and a body line per notification, line breaks in the
+// body are sent as \037
+static const char NOTIFY_HELPER[] =
+    "while IFS= read -r title && IFS= read -r body; do "
+    "notify-send -a awm -- \"$title\" "
+    "\"$(printf '%s' \"$body\" | tr '\\037' '\\n')\"; "
+    "done";
+
+static std::mutex queue_mutex;
+static std::vector<std::pair<std::string, std::string>> queue;
+static Notifier *notifier = nullptr;
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void queue_notification(std::string title, std::string message) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    if (queue.size() == NOTIFY_QUEUE_SIZE)
+        return;
+
+    queue.emplace_back(std::move(title), std::move(message));
+
+    // the event loop has been woken for a queue that was not empty
+    if (notifier && queue.size() == 1)
+        eventfd_write(notifier->wake_fd, 1);
+}
+
+Notifier::Notifier(Server *server) : server(server) {
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    wake_source = wl_event_loop_add_fd(
+        server->event_loop, wake_fd, WL_EVENT_READABLE,
+        [](int fd, [[maybe_unused]] uint32_t mask, void *data) {
+            eventfd_t value;
+            eventfd_read(fd, &value);
+
+            static_cast<Notifier *>(data)->drain();
+            return 0;
+        },
+        this);
+
+    batch_timer = wl_event_loop_add_timer(
+        server->event_loop,
+        [](void *data) {
+            static_cast<Notifier *>(data)->flush();
+            return 0;
+        },
+        this);
+
+    // pick up what was queued while the config was loaded
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        notifier = this;
+    }
+    drain();
+}
+
+Notifier::~Notifier() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        notifier = nullptr;
+    }
+
+    wl_event_source_remove(wake_source);
+    wl_event_source_remove(batch_timer);
+    close(wake_fd);
+
+    // the helper exits when its input is closed
+    stop_helper();
+}
+
+// post the notifications queued from any thread
+void Notifier::drain() {
+    std::vector<std::pair<std::string, std::string>> pending;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        pending.swap(queue);
+    }
+
+    for (const auto &[title, message] : pending)
+        post(title, message);
+}
+
+void Notifier::post(const std::string &title, const std::string &message) {
+    const int64_t now = now_ms();
+
+    // a repeat of the last notification only counts up
+    if (!recent.empty() && recent.back().title == title &&
+        recent.back().message == message) {
+        ++recent.back().count;
+        recent.back().time = std::time(nullptr);
+        recent.back().posted_ms = now;
+    } else {
+        recent.push_back(
+            {next_id++, title, message, 1, std::time(nullptr), now});
+        if (recent.size() > NOTIFY_HISTORY)
+            recent.pop_front();
+    }
+
+    if (IPC *ipc = server->ipc)
+        ipc->notify_clients_later({IPC_NOTIFICATION_LIST});
+
+    // merge into the batch waiting to be sent
+    for (Notification &waiting : batch)
+        if (waiting.title == title && waiting.message == message) {
+            ++waiting.count;
+            return;
+        }
+
+    // identical messages reach the desktop once per repeat window
+    if (auto it = last_sent.find(title + '\n' + message);
+        it != last_sent.end() && now - it->second < NOTIFY_REPEAT_MS)
+        return;
+
+    batch.push_back(recent.back());
+    batch.back().count = 1;
+
+    if (batch.size() == 1)
+        wl_event_source_timer_update(batch_timer, NOTIFY_BATCH_MS);
+}
+
+// send the batch as one notification per title
+void Notifier::flush() {
+    if (batch.empty())
+        return;
+
+    const int64_t now = now_ms();
+
+    // forget messages whose repeat window has passed
+    for (auto it = last_sent.begin(); it != last_sent.end();)
+        if (now - it->second >= NOTIFY_REPEAT_MS)
+            it = last_sent.erase(it);
+        else
+            ++it;
+
+    std::string data;
+    std::vector<bool> sent(batch.size());
+    for (size_t i = 0; i != batch.size(); ++i) {
+        if (sent[i])
+            continue;
+
+        std::string title = batch[i].title, body;
+        size_t lines = 0, more = 0;
+        for (size_t j = i; j != batch.size(); ++j) {
+            if (sent[j] || batch[j].title != title)
+                continue;
+
+            sent[j] = true;
+            last_sent[title + '\n' + batch[j].message] = now;
+
+            if (lines == NOTIFY_BATCH_LINES) {
+                ++more;
+                continue;
+            }
+
+            if (lines++)
+                body += '\n';
+            body += batch[j].message;
+            if (batch[j].count > 1)
+                body += " (x" + std::to_string(batch[j].count) + ")";
+        }
+
+        if (more)
+            body += "\nand " + std::to_string(more) + " more";
+
+        // one line each for the helper
+        std::replace(title.begin(), title.end(), '\n', ' ');
+        std::replace(body.begin(), body.end(), '\n', '\037');
+        data += title + '\n' + body + '\n';
+    }
+
+    batch.clear();
+
+    // a helper that has gone away is replaced once
+    for (int attempt = 0; attempt != 2; ++attempt) {
+        if (helper_fd < 0 && !start_helper())
+            break;
+
+        const ssize_t written =
+            send(helper_fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (written == static_cast<ssize_t>(data.size()))
+            return;
+
+        // a partial write would pair titles with the wrong bodies
+        stop_helper();
+    }
+
+    wlr_log(WLR_ERROR, "%s", "failed to hand notifications to notify-send");
+}
+
+bool Notifier::start_helper() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds))
+        return false;
+
+    // a full socket drops a batch instead of stalling the compositor, the
+    // helper's end blocks as sh expects
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    LaunchOptions options;
+    options.stdin_fd = fds[1];
+    helper = spawn_process({"/bin/sh", "-c", NOTIFY_HELPER}, options);
+    close(fds[1]);
+
+    if (helper < 0) {
+        close(fds[0]);
+        return false;
+    }
+
+    helper_fd = fds[0];
+    return true;
+}
+
+void Notifier::stop_helper() {
+    if (helper_fd >= 0)
+        close(helper_fd);
+    helper_fd = -1;
+    helper = -1;
+}
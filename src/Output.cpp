@@ -2,6 +2,7 @@
 #include "BSPTree.h"
 #include "Config.h"
 #include "LayerSurface.h"
+#include "LayoutState.h"
 #include "OutputManager.h"
 #include "Server.h"
 #include "Toplevel.h"
@@ -107,11 +108,14 @@ Output::Output(Server *server, struct wlr_output *wlr_output)
         return;
     }
 
-    // create initial workspaces through WorkspaceManager
+    // adopt workspaces of a previous output with the same name, otherwise
+    // only the first workspace is created, the rest are created on first use
     if (!server->workspace_manager->adopt_workspaces(this)) {
-        for (int i = 1; i <= 10; ++i)
-            server->workspace_manager->new_workspace(this, i);
         set_workspace(1);
+
+        // bring back the workspaces this output had in the last session
+        if (server->layout_state)
+            server->layout_state->restore_output(this);
     }
 
     // create layers
@@ -165,6 +169,9 @@ Output::Output(Server *server, struct wlr_output *wlr_output)
             wl_event_source_timer_update(output->repaint_timer, delay);
         }
 
+        // anything may have moved under the cursor since the last frame
+        output->server->cursor->invalidate_hit();
+
         // render scene
         wlr_scene_output *scene_output = wlr_scene_get_scene_output(
             output->server->scene, output->wlr_output);
@@ -304,16 +311,9 @@ void Output::arrange_layers() {
         usable_area = usable;
         
         // retile all workspaces that have auto_tile enabled
-        Workspace *workspace;
-        wl_list_for_each(workspace, &server->workspace_manager->workspaces, link) {
-            if (workspace->output == this && workspace->auto_tile) {
-                if (workspace->bsp_tree) {
-                    workspace->bsp_tree->apply_layout(usable_area);
-                } else {
-                    workspace->tile();
-                }
-            }
-        }
+        for (Workspace *workspace : workspaces)
+            if (workspace && workspace->auto_tile)
+                workspace->schedule_layout();
     }
 
     // handle keyboard interactive layers
@@ -402,8 +402,9 @@ Workspace *Output::get_active() {
     return server->workspace_manager->get_active_workspace(this);
 }
 
+// get workspace n, created on first use
 Workspace *Output::get_workspace(const uint32_t n) {
-    return server->workspace_manager->get_workspace(n, this);
+    return server->workspace_manager->ensure_workspace(n, this);
 }
 
 // change the focused workspace to passed workspace
@@ -28,6 +28,21 @@ Popup::Popup(wlr_xdg_popup *xdg_popup, wlr_scene_tree *parent_tree,
     };
     wl_signal_add(&xdg_popup->base->surface->events.commit, &commit);
 
+    // xdg_popup_map and xdg_popup_unmap, the popup covers or uncovers the
+    // cached hit
+    map.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
+        Popup *popup = wl_container_of(listener, popup, map);
+        popup->server->cursor->invalidate_hit();
+    };
+    wl_signal_add(&xdg_popup->base->surface->events.map, &map);
+
+    unmap.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
+        Popup *popup = wl_container_of(listener, popup, unmap);
+        if (!popup->server->shutting_down)
+            popup->server->cursor->invalidate_hit();
+    };
+    wl_signal_add(&xdg_popup->base->surface->events.unmap, &unmap);
+
     // xdg_popup_reposition
     reposition.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
         Popup *popup = wl_container_of(listener, popup, reposition);
@@ -55,6 +70,8 @@ Popup::Popup(wlr_xdg_popup *xdg_popup, wlr_scene_tree *parent_tree,
 
 Popup::~Popup() {
     wl_list_remove(&commit.link);
+    wl_list_remove(&map.link);
+    wl_list_remove(&unmap.link);
     wl_list_remove(&reposition.link);
     wl_list_remove(&new_popup.link);
     wl_list_remove(&destroy.link);
@@ -1,14 +1,23 @@
 #include "Server.h"
 #include "ActivationToken.h"
 #include "BSPTree.h"
+#include "Decoration.h"
 #include "IdleInhibitor.h"
 #include "Keyboard.h"
+#include "KeymapCache.h"
+#include "LayoutState.h"
 #include "SessionLock.h"
 #include "TearingController.h"
 #include "wlr.h"
+#include <cstring>
+#include <filesystem>
 #include <mutex>
+#include <sys/inotify.h>
 #include <sys/signalfd.h>
 
+// delay before reloading a changed config, absorbs editor save bursts
+constexpr int CONFIG_RELOAD_DEBOUNCE_MS = 100;
+
 static pid_t get_parent_pid(pid_t child) {
     pid_t parent = -1;
     char file_name[100];
@@ -42,69 +51,56 @@ Workspace *Server::get_workspace(Toplevel *toplevel) const {
     return workspace_manager->get_workspace_for_toplevel(toplevel);
 }
 
-// get a node tree surface from its location and cast it to the generic
-// type provided
-template <typename T>
-T *Server::surface_at(const double lx, const double ly, wlr_surface **surface,
-                      double *sx, double *sy) {
-    // get the scene node and ensure it's a buffer
-    wlr_scene_node *node = wlr_scene_node_at(&scene->tree.node, lx, ly, sx, sy);
-    if (!node || node->type != WLR_SCENE_NODE_BUFFER)
-        return nullptr;
-
-    // get the scene buffer and surface of the node
-    wlr_scene_buffer *scene_buffer = wlr_scene_buffer_from_node(node);
-    wlr_scene_surface *scene_surface =
-        wlr_scene_surface_try_from_buffer(scene_buffer);
-    if (!scene_surface || !scene_surface->surface)
-        return nullptr;
-
-    // set the scene surface
-    *surface = scene_surface->surface;
-
-    // get the scene tree of the node's parent
-    wlr_scene_tree *tree = node->parent;
-    if (!tree || tree->node.type != WLR_SCENE_NODE_TREE)
-        return nullptr;
-
-    // find the topmost node of the scene tree
-    while (tree && !tree->node.data)
-        tree = tree->node.parent;
-
-    // invalid tree
-    if (!tree || !tree->node.parent)
-        return nullptr;
+// find what is under a layout position in a single scene traversal
+Hit Server::hit_test(const double lx, const double ly) const {
+    Hit hit;
+    hit.node = wlr_scene_node_at(&scene->tree.node, lx, ly, &hit.sx, &hit.sy);
+    if (!hit.node)
+        return hit;
+
+    // decoration parts are rects directly below the decoration tree
+    if (hit.node->type == WLR_SCENE_NODE_RECT) {
+        if (hit.node->parent && hit.node->parent->node.data) {
+            hit.decoration =
+                static_cast<Decoration *>(hit.node->parent->node.data);
+            hit.toplevel = hit.decoration->toplevel;
+            hit.type = HIT_DECORATION;
+        }
 
-    // return the topmost node's data
-    return static_cast<T *>(tree->node.data);
-}
+        return hit;
+    }
 
-// find a toplevel by location
-Toplevel *Server::toplevel_at(const double lx, const double ly,
-                              wlr_surface **surface, double *sx, double *sy) {
-    Toplevel *toplevel = surface_at<Toplevel>(lx, ly, surface, sx, sy);
+    if (hit.node->type != WLR_SCENE_NODE_BUFFER)
+        return hit;
 
-    // ensure role is not layer surface
-    if (toplevel && surface && (*surface)->mapped &&
-        strcmp((*surface)->role->name, "zwlr_layer_surface_v1") != 0)
-        return toplevel;
+    wlr_scene_surface *scene_surface = wlr_scene_surface_try_from_buffer(
+        wlr_scene_buffer_from_node(hit.node));
+    if (!scene_surface || !scene_surface->surface)
+        return hit;
 
-    return nullptr;
-}
+    hit.surface = scene_surface->surface;
 
-// find a layer surface by location
-LayerSurface *Server::layer_surface_at(const double lx, const double ly,
-                                       wlr_surface **surface, double *sx,
-                                       double *sy) {
-    LayerSurface *layer_surface =
-        surface_at<LayerSurface>(lx, ly, surface, sx, sy);
+    // classify by the role of the root surface, walking up through popups
+    wlr_surface *root = wlr_surface_get_root_surface(hit.surface);
+    while (wlr_xdg_popup *popup = wlr_xdg_popup_try_from_wlr_surface(root)) {
+        if (!popup->parent)
+            return hit;
 
-    // ensure role is layer surface
-    if (layer_surface && surface && (*surface)->mapped &&
-        strcmp((*surface)->role->name, "zwlr_layer_surface_v1") == 0)
-        return layer_surface;
+        root = wlr_surface_get_root_surface(popup->parent);
+        hit.popup = true;
+    }
 
-    return nullptr;
+    if (wlr_layer_surface_v1 *layer_surface =
+            wlr_layer_surface_v1_try_from_wlr_surface(root)) {
+        hit.layer_surface = static_cast<LayerSurface *>(layer_surface->data);
+        if (hit.layer_surface)
+            hit.type = HIT_LAYER_SURFACE;
+    } else if (wlr_session_lock_surface_v1_try_from_wlr_surface(root))
+        hit.type = HIT_LOCK_SURFACE;
+    else if ((hit.toplevel = get_toplevel(root)))
+        hit.type = HIT_TOPLEVEL;
+
+    return hit;
 }
 
 // get output by wlr_output
@@ -143,21 +139,21 @@ bool Server::handle_bind(Bind bind) {
     // digit pressed
     int n = 1;
 
-    // handle digits
-    if (bind.sym >= XKB_KEY_0 && bind.sym <= XKB_KEY_9) {
-        // 0 is on the right of 9 so it makes more sense this way
-        n = XKB_KEY_0 == bind.sym ? 10 : bind.sym - XKB_KEY_0;
+    // user-defined command
+    int32_t command = -1;
 
-        // digit pressed
-        bind.sym = XKB_KEY_NoSymbol;
-    }
+    if (bind.name == BIND_NONE) {
+        // locate in the compiled bind table
+        const BindAction *action = config->find_bind(bind.modifiers, bind.sym);
+        if (!action)
+            return false;
 
-    // locate in wm binds
-    for (Bind b : config->binds)
-        if (b == bind) {
-            bind.name = b.name;
-            break;
-        }
+        bind.name = action->name;
+        n = action->n;
+        command = action->command;
+    } else if (bind.sym >= XKB_KEY_0 && bind.sym <= XKB_KEY_9)
+        // 0 is on the right of 9 so it makes more sense this way
+        n = XKB_KEY_0 == bind.sym ? 10 : bind.sym - XKB_KEY_0;
 
     // use bind exit as exit shortcuts inhibitor
     if (active_keyboard_shortcuts_inhibitor) {
@@ -265,19 +261,7 @@ bool Server::handle_bind(Bind bind) {
                         workspace->bsp_tree->remove(active);
                     }
 
-                    if (workspace->pending_layout_idle)
-                        wl_event_source_remove(workspace->pending_layout_idle);
-
-                    workspace->pending_layout_idle = wl_event_loop_add_idle(
-                        wl_display_get_event_loop(display),
-                        [](void *data) {
-                            Workspace *ws = static_cast<Workspace *>(data);
-                            ws->pending_layout_idle = nullptr;
-                            if (ws->bsp_tree)
-                                ws->bsp_tree->apply_layout(
-                                    ws->output->usable_area);
-                        },
-                        workspace);
+                    workspace->schedule_layout();
                 } else {
                     workspace->tile();
                 }
@@ -326,19 +310,7 @@ bool Server::handle_bind(Bind bind) {
                             active, output->usable_area, new_geometry))
                         active->set_position_size(new_geometry);
 
-                    if (workspace->pending_layout_idle)
-                        wl_event_source_remove(workspace->pending_layout_idle);
-
-                    workspace->pending_layout_idle = wl_event_loop_add_idle(
-                        wl_display_get_event_loop(display),
-                        [](void *data) {
-                            Workspace *ws = static_cast<Workspace *>(data);
-                            ws->pending_layout_idle = nullptr;
-                            if (ws->bsp_tree)
-                                ws->bsp_tree->apply_layout(
-                                    ws->output->usable_area);
-                        },
-                        workspace);
+                    workspace->schedule_layout();
                 } else {
                     workspace->tile();
                 }
@@ -414,13 +386,13 @@ bool Server::handle_bind(Bind bind) {
     case BIND_NONE:
     default: {
         // handle user-defined binds
-        for (const auto &[cmd_bind, cmd] : config->commands)
-            if (cmd_bind == bind) {
-                spawn(cmd);
-                return true;
-            }
+        if (command < 0)
+            return false;
 
-        return false;
+        LaunchOptions options;
+        options.activation_token = true;
+        spawn(config->commands[command].second, options);
+        return true;
     }
     }
 
@@ -477,9 +449,9 @@ void Server::clean_activation_tokens() {
 }
 
 // run a command with sh
-void Server::spawn(const std::string &command) const {
-    if (fork() == 0)
-        execl("/bin/sh", "/bin/sh", "-c", command.c_str(), nullptr);
+pid_t Server::spawn(const std::string &command,
+                    const LaunchOptions &options) const {
+    return launcher->spawn(command, options);
 }
 
 static void recreate_renderer(void *data) {
@@ -604,6 +576,15 @@ Server::Server(Config *config) : config(config) {
     // transaction manager
     transaction_manager = new TransactionManager(this);
 
+    // layout state of the previous session
+    layout_state = new LayoutState(this);
+
+    // process launcher
+    launcher = new Launcher(this);
+
+    // notifications, including those queued while the config was loaded
+    notifier = new Notifier(this);
+
     // scene
     scene = wlr_scene_create();
     scene_layout =
@@ -720,6 +701,7 @@ Server::Server(Config *config) : config(config) {
 
     // keyboards
     wl_list_init(&keyboards);
+    keymap_cache = new KeymapCache(this);
 
     // xdg activation
     wl_list_init(&pending_activation_tokens);
@@ -1030,7 +1012,7 @@ Server::Server(Config *config) : config(config) {
 
         Toplevel *toplevel =
             static_cast<Toplevel *>(event->toplevel->base->data);
-        toplevel->tag = event->tag;
+        toplevel->update_tag(event->tag);
     };
     wl_signal_add(&wlr_xdg_toplevel_tag_manager->events.set_tag,
                   &xdg_toplevel_set_tag);
@@ -1276,8 +1258,7 @@ Server::Server(Config *config) : config(config) {
             Server *server = static_cast<Server *>(data);
             switch (fdsi.ssi_signo) {
             case SIGCHLD:
-                while (waitpid(-1, nullptr, WNOHANG) > 0)
-                    ;
+                server->launcher->reap();
                 break;
             case SIGINT:
             case SIGTERM:
@@ -1322,24 +1303,198 @@ Server::Server(Config *config) : config(config) {
     for (const std::string &command : systemd_user_env)
         spawn(command);
 
-    // add config updater to event loop
-    config_update_timer = wl_event_loop_add_timer(
+    // reload the config when it changes
+    watch_config();
+
+    // run event loop
+    wlr_log(WLR_INFO, "Running Wayland compositor on WAYLAND_DISPLAY=%s",
+            socket.c_str());
+    wl_display_run(display);
+}
+
+// watch the config file and its directory. editors that save by renaming a
+// new file over the config are only seen through the directory, bursts of
+// events from a single save are merged into one reload
+void Server::watch_config() {
+    if (config->path.empty())
+        return;
+
+    config_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (config_watch_fd < 0) {
+        wlr_log(WLR_ERROR, "failed to watch config: %s", strerror(errno));
+        return;
+    }
+
+    const std::filesystem::path path(config->path);
+    const std::filesystem::path dir =
+        path.has_parent_path() ? path.parent_path() : ".";
+    config_watch_name = path.filename();
+
+    if (inotify_add_watch(config_watch_fd, dir.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+        wlr_log(WLR_ERROR, "failed to watch `%s`: %s", dir.c_str(),
+                strerror(errno));
+    watch_config_file();
+
+    config_reload_timer = wl_event_loop_add_timer(
         event_loop,
         [](void *data) {
             Server *server = static_cast<Server *>(data);
 
-            server->config->update(server);
+            // a replaced file needs a new watch
+            server->watch_config_file();
+            server->reload_config();
+            return 0;
+        },
+        this);
+
+    config_watch = wl_event_loop_add_fd(
+        event_loop, config_watch_fd, WL_EVENT_READABLE,
+        [](int fd, [[maybe_unused]] uint32_t mask, void *data) {
+            Server *server = static_cast<Server *>(data);
+
+            alignas(inotify_event) char buffer[4096];
+            bool changed = false;
+            ssize_t len;
+            while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+                for (char *p = buffer; p < buffer + len;) {
+                    const auto *event = reinterpret_cast<inotify_event *>(p);
+                    p += sizeof(inotify_event) + event->len;
+
+                    // directory events carry the name of the entry
+                    if (event->wd == server->config_watch_file ||
+                        (event->len &&
+                         server->config_watch_name == event->name))
+                        changed = true;
+                }
 
-            wl_event_source_timer_update(server->config_update_timer, 1000);
+            if (changed)
+                wl_event_source_timer_update(server->config_reload_timer,
+                                             CONFIG_RELOAD_DEBOUNCE_MS);
             return 0;
         },
         this);
-    wl_event_source_timer_update(config_update_timer, 1000);
+}
 
-    // run event loop
-    wlr_log(WLR_INFO, "Running Wayland compositor on WAYLAND_DISPLAY=%s",
-            socket.c_str());
-    wl_display_run(display);
+// (re)add the watch on the config file itself, following symlinks
+void Server::watch_config_file() {
+    if (config_watch_file >= 0)
+        inotify_rm_watch(config_watch_fd, config_watch_file);
+
+    config_watch_file = inotify_add_watch(
+        config_watch_fd, config->path.c_str(),
+        IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF);
+}
+
+// find an output config by output name
+static OutputConfig *find_output_config(const Config *config,
+                                        const std::string &name) {
+    for (OutputConfig *output_config : config->outputs)
+        if (output_config->name == name)
+            return output_config;
+
+    return nullptr;
+}
+
+// parse the config again and re-apply the sections that changed
+void Server::reload_config() {
+    // compare the text, a file swapped in by rename or a new symlink can
+    // keep the modification time of the old one
+    std::string source;
+    if (!Config::read(config->path, source) || source == config->source)
+        return;
+
+    wlr_log(WLR_INFO, "%s", "config file modified, reloading");
+
+    // the live config stays in place if the new one does not parse, the
+    // broken text is not reported again until it changes
+    Config *next = new Config(config->path, std::move(source));
+    if (!next->loaded) {
+        config->source = next->source;
+        delete next;
+        return;
+    }
+
+    const uint32_t changed = next->diff(*config);
+
+    // everything reads the config through this pointer, so swapping it
+    // switches all sections at once
+    Config *previous = config;
+    config = next;
+
+    if (changed & CONFIG_KEYBOARD) {
+        Keyboard *keyboard, *tmp;
+        wl_list_for_each_safe(keyboard, tmp, &keyboards, link)
+            keyboard->update_config();
+    }
+
+    if (changed & CONFIG_POINTER)
+        cursor->reconfigure_all();
+
+    if (changed & CONFIG_XCURSOR)
+        cursor->reload_xcursor();
+
+    // only outputs whose own config changed are committed again
+    if (changed & CONFIG_OUTPUTS) {
+        Output *output, *tmp;
+        wl_list_for_each_safe(output, tmp, &output_manager->outputs, link) {
+            const std::string name = output->wlr_output->name;
+            OutputConfig *output_config = find_output_config(config, name);
+            const OutputConfig *previous_config =
+                find_output_config(previous, name);
+
+            if (output_config &&
+                (!previous_config || !(*output_config == *previous_config)))
+                output->apply_config(output_config, false);
+        }
+
+        output_manager->arrange();
+
+        if (ipc)
+            ipc->notify_clients(IPC_OUTPUT_MODES);
+    }
+
+    // auto tiled workspaces are laid out again with the new method
+    if (changed & CONFIG_TILING &&
+        config->tiling.method != previous->tiling.method) {
+        Output *output, *tmp;
+        wl_list_for_each_safe(output, tmp, &output_manager->outputs, link) {
+            for (Workspace *workspace : output->workspaces)
+                if (workspace && workspace->auto_tile)
+                    workspace->retile();
+        }
+    }
+
+    // rule indices of mapped toplevels point into the new rule list, they
+    // are matched again without applying anything
+    if (changed & CONFIG_RULES) {
+        auto rematch = [this](Workspace *workspace) {
+            Toplevel *toplevel, *tmp;
+            wl_list_for_each_safe(toplevel, tmp, &workspace->toplevels, link)
+                toplevel->rule = config->rule_index.match_index(toplevel);
+        };
+
+        Output *output, *tmp;
+        wl_list_for_each_safe(output, tmp, &output_manager->outputs, link) {
+            for (Workspace *workspace : output->workspaces)
+                if (workspace)
+                    rematch(workspace);
+        }
+
+        // workspaces of unplugged outputs return with the new rule list
+        for (const auto &[name, orphaned] :
+             workspace_manager->orphaned_outputs_map)
+            for (Workspace *workspace : orphaned.workspaces)
+                rematch(workspace);
+    }
+
+    // binds and general settings are read when used, the swap is all they
+    // need
+
+    delete previous;
+
+    wlr_log(WLR_INFO, "config reloaded, changed sections 0x%x", changed);
+    notify_send("Config", "%s", "config reload complete");
 }
 
 // stop server and run exit commands
@@ -1360,6 +1515,11 @@ void Server::exit() {
 Server::~Server() {
     shutting_down = true;
 
+    // snapshot the layout while every toplevel is still mapped
+    layout_state->save();
+    delete layout_state;
+    layout_state = nullptr;
+
     wl_list_remove(&renderer_lost.link);
 
     wl_list_remove(&new_xdg_toplevel.link);
@@ -1396,6 +1556,7 @@ Server::~Server() {
 
     Keyboard *kb, *kbt;
     wl_list_for_each_safe(kb, kbt, &keyboards, link) delete kb;
+    delete keymap_cache;
 
     LayerSurface *ls, *lst;
     wl_list_for_each_safe(ls, lst, &layer_surfaces, link) delete ls;
@@ -1409,7 +1570,15 @@ Server::~Server() {
     wl_display_destroy_clients(display);
 
     wl_event_source_remove(signal_handler);
-    wl_event_source_remove(config_update_timer);
+    delete notifier;
+    notifier = nullptr;
+    delete launcher;
+
+    if (config_watch) {
+        wl_event_source_remove(config_watch);
+        wl_event_source_remove(config_reload_timer);
+        close(config_watch_fd);
+    }
 
     wlr_allocator_destroy(allocator);
     wlr_renderer_destroy(renderer);
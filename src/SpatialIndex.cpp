@@ -0,0 +1,126 @@
+#include "SpatialIndex.h"
+#include "Toplevel.h"
+#include <algorithm>
+#include <cstdlib>
+
+static bool entry_less(const SpatialEntry &a, const SpatialEntry &b) {
+    if (a.edge != b.edge)
+        return a.edge < b.edge;
+    return a.order < b.order;
+}
+
+void SpatialIndex::update(wl_list *toplevels, uint64_t serial) {
+    if (this->serial == serial)
+        return;
+
+    this->serial = serial;
+
+    // capacity is kept across rebuilds
+    left.clear();
+    right.clear();
+    top.clear();
+    bottom.clear();
+
+    uint32_t order = 0;
+    Toplevel *toplevel, *tmp;
+    wl_list_for_each_safe(toplevel, tmp, toplevels, link) {
+        const wlr_box &geo = toplevel->geometry;
+        left.push_back({geo.x, order, geo, toplevel});
+        right.push_back({geo.x + geo.width, order, geo, toplevel});
+        top.push_back({geo.y, order, geo, toplevel});
+        bottom.push_back({geo.y + geo.height, order, geo, toplevel});
+        ++order;
+    }
+
+    std::sort(left.begin(), left.end(), entry_less);
+    std::sort(right.begin(), right.end(), entry_less);
+    std::sort(top.begin(), top.end(), entry_less);
+    std::sort(bottom.begin(), bottom.end(), entry_less);
+}
+
+std::pair<const SpatialEntry *, const SpatialEntry *>
+SpatialIndex::range(const std::vector<SpatialEntry> &list, int min, int max) {
+    const SpatialEntry *begin = list.data();
+    const SpatialEntry *end = begin + list.size();
+
+    const SpatialEntry *first = std::lower_bound(
+        begin, end, min,
+        [](const SpatialEntry &e, int edge) { return e.edge < edge; });
+    const SpatialEntry *last = std::upper_bound(
+        first, end, max,
+        [](int edge, const SpatialEntry &e) { return edge < e.edge; });
+
+    return {first, last};
+}
+
+Toplevel *SpatialIndex::nearest(const wlr_box &from,
+                                const wlr_direction direction) const {
+    constexpr int min = std::numeric_limits<int>::min();
+    constexpr int max = std::numeric_limits<int>::max();
+
+    // the closest edge strictly past from is at one end of the range
+    std::pair<const SpatialEntry *, const SpatialEntry *> r;
+    bool horizontal = false;
+    switch (direction) {
+    case WLR_DIRECTION_UP:
+        r = range(top, min, from.y - 1);
+        if (r.first != r.second)
+            r = range(top, (r.second - 1)->edge, (r.second - 1)->edge);
+        break;
+    case WLR_DIRECTION_DOWN:
+        r = range(top, from.y + 1, max);
+        if (r.first != r.second)
+            r = range(top, r.first->edge, r.first->edge);
+        break;
+    case WLR_DIRECTION_LEFT:
+        r = range(left, min, from.x - 1);
+        if (r.first != r.second)
+            r = range(left, (r.second - 1)->edge, (r.second - 1)->edge);
+        horizontal = true;
+        break;
+    case WLR_DIRECTION_RIGHT:
+        r = range(left, from.x + 1, max);
+        if (r.first != r.second)
+            r = range(left, r.first->edge, r.first->edge);
+        horizontal = true;
+        break;
+    default:
+        return nullptr;
+    }
+
+    // pick the smallest displacement on the other axis, entries with the same
+    // edge are already in list order
+    const SpatialEntry *best = nullptr;
+    int best_secondary = max;
+    for (const SpatialEntry *e = r.first; e != r.second; ++e) {
+        int secondary = horizontal ? std::abs(from.y - e->box.y)
+                                   : std::abs(from.x - e->box.x);
+        if (secondary < best_secondary) {
+            best = e;
+            best_secondary = secondary;
+        }
+    }
+
+    return best ? best->toplevel : nullptr;
+}
+
+void SpatialIndex::adjacent(const wlr_box &box, const int threshold,
+                            std::vector<Toplevel *> &out) const {
+    size_t start = out.size();
+
+    auto collect = [&](const std::vector<SpatialEntry> &list, int edge) {
+        auto r = range(list, edge - threshold + 1, edge + threshold - 1);
+        for (const SpatialEntry *e = r.first; e != r.second; ++e)
+            out.push_back(e->toplevel);
+    };
+
+    // left edges near the right edge, right edges near the left edge, etc.
+    collect(left, box.x + box.width);
+    collect(right, box.x);
+    collect(top, box.y + box.height);
+    collect(bottom, box.y);
+
+    // drop duplicates of toplevels touching several edges
+    std::sort(out.begin() + start, out.end());
+    out.erase(std::unique(out.begin() + start, out.end()), out.end());
+}
@@ -2,6 +2,7 @@
 #include "BSPTree.h"
 #include "Config.h"
 #include "IPC.h"
+#include "LayoutState.h"
 #include "Output.h"
 #include "OutputManager.h"
 #include "Popup.h"
@@ -10,6 +11,10 @@
 #include "WindowRule.h"
 #include "Workspace.h"
 
+// title and app_id changes closer together than this are checked against the
+// window rules once
+constexpr int RULE_CHECK_DELAY_MS = 100;
+
 void Toplevel::map_notify(wl_listener *listener, [[maybe_unused]] void *data) {
     // on map or display
     Toplevel *toplevel = wl_container_of(listener, toplevel, map);
@@ -21,13 +26,24 @@ void Toplevel::map_notify(wl_listener *listener, [[maybe_unused]] void *data) {
     toplevel->update_pid();
 
     // apply rule
-    WindowRule *matching_rule = nullptr;
-    for (WindowRule *rule : server->config->window_rules)
-        if (rule->matches(toplevel)) {
-            matching_rule = rule;
-            output = server->output_manager->get_output(matching_rule->output);
-            break;
-        }
+    const WindowRuleIndex &rule_index = server->config->rule_index;
+    toplevel->rule = rule_index.match_index(toplevel);
+    WindowRule *matching_rule =
+        toplevel->rule < 0 ? nullptr : rule_index.rules[toplevel->rule];
+    if (matching_rule)
+        output = server->output_manager->get_output(matching_rule->output);
+
+    // claim the slot this window had in the last session
+    SavedWindow *saved = nullptr;
+    Workspace *saved_workspace = nullptr;
+    if (!matching_rule && server->layout_state &&
+        (saved = server->layout_state->match(toplevel))) {
+        saved_workspace = server->layout_state->workspace_for(saved);
+        if (saved_workspace)
+            output = saved_workspace->output;
+        else
+            saved = nullptr;
+    }
 
     if (!output)
         output = server->focused_output();
@@ -70,14 +86,18 @@ void Toplevel::map_notify(wl_listener *listener, [[maybe_unused]] void *data) {
         width = std::min(width, static_cast<uint32_t>(usable_area.width));
         height = std::min(height, static_cast<uint32_t>(usable_area.height));
 
-        Workspace *workspace = output->get_active();
-        if (!matching_rule && workspace && workspace->auto_tile) {
+        Workspace *workspace = saved ? saved_workspace : output->get_active();
+        if (!matching_rule && workspace && workspace->auto_tile &&
+            !(saved && saved->floating)) {
             toplevel->geometry.width = width;
             toplevel->geometry.height = height;
 
             // hide the scene node until tile() positions it
             wlr_scene_node_set_enabled(&toplevel->scene_tree->node, false);
             toplevel->scene_hidden_for_autotile = true;
+        } else if (saved) {
+            // put the toplevel back where it was
+            toplevel->set_position_size(saved->geometry);
         } else {
             wlr_box output_box = output->layout_geometry;
 
@@ -116,12 +136,8 @@ void Toplevel::map_notify(wl_listener *listener, [[maybe_unused]] void *data) {
                 return;
 
             // commit if part of transaction
-            if (toplevel->in_transaction) {
-                Transaction *txn =
-                    toplevel->server->transaction_manager->current();
-                if (txn && txn->contains(toplevel))
-                    txn->handle_commit(toplevel);
-            }
+            if (toplevel->in_transaction && toplevel->transaction)
+                toplevel->transaction->handle_commit(toplevel);
 
             wlr_surface_state *state = &xwayland_surface->surface->current;
             wlr_box *current = &toplevel->geometry;
@@ -152,8 +168,9 @@ void Toplevel::map_notify(wl_listener *listener, [[maybe_unused]] void *data) {
         int width = std::min((int)xwayland_surface->width, area.width);
         int height = std::min((int)xwayland_surface->height, area.height);
 
-        Workspace *workspace = output->get_active();
-        if (!matching_rule && workspace && workspace->auto_tile) {
+        Workspace *workspace = saved ? saved_workspace : output->get_active();
+        if (!matching_rule && workspace && workspace->auto_tile &&
+            !(saved && saved->floating)) {
             toplevel->geometry.x = 0;
             toplevel->geometry.y = 0;
             toplevel->geometry.width = width;
@@ -162,6 +179,9 @@ void Toplevel::map_notify(wl_listener *listener, [[maybe_unused]] void *data) {
             // hide the scene node until tile() positions it
             wlr_scene_node_set_enabled(&toplevel->scene_tree->node, false);
             toplevel->scene_hidden_for_autotile = true;
+        } else if (saved) {
+            // put the toplevel back where it was
+            toplevel->set_position_size(saved->geometry);
         } else {
             // get surface position
             int x = xwayland_surface->x;
@@ -208,6 +228,9 @@ void Toplevel::map_notify(wl_listener *listener, [[maybe_unused]] void *data) {
     if (matching_rule) {
         // apply window rule
         matching_rule->apply(toplevel);
+    } else if (saved) {
+        // place into the saved workspace and slot
+        server->layout_state->restore(toplevel, saved, saved_workspace);
     } else {
         // set floating state based on size constraints if no rule matches
         toplevel->is_floating = toplevel->should_be_floating();
@@ -224,6 +247,9 @@ void Toplevel::map_notify(wl_listener *listener, [[maybe_unused]] void *data) {
 
     toplevel->update_ext_foreign();
 
+    // the new surface may cover the cached hit
+    server->cursor->invalidate_hit();
+
     // set surface to fullscreen state if disable_decorations is enabled
     // this disables client-side decorations without actually fullscreening
     if (server->config->general.disable_decorations) {
@@ -247,11 +273,13 @@ void Toplevel::unmap_notify(wl_listener *listener,
     Toplevel *toplevel = wl_container_of(listener, toplevel, unmap);
     Server *server = toplevel->server;
 
+    // the surface no longer takes input
+    if (!server->shutting_down)
+        server->cursor->invalidate_hit();
+
     // remove from any active transaction
-    if (toplevel->in_transaction && server->transaction_manager) {
+    if (toplevel->transaction && server->transaction_manager)
         server->transaction_manager->remove_toplevel(toplevel);
-        toplevel->in_transaction = false;
-    }
 
     // deactivate
     if (toplevel == server->seat->grabbed_toplevel)
@@ -261,8 +289,15 @@ void Toplevel::unmap_notify(wl_listener *listener,
     if (Workspace *workspace = server->get_workspace(toplevel))
         workspace->close(toplevel);
 
+    // forget any slot claimed from the last session
+    if (server->layout_state)
+        server->layout_state->release(toplevel);
+
     // remove links
+    if (toplevel->workspace)
+        toplevel->workspace->geometry_changed();
     wl_list_remove(&toplevel->link);
+    toplevel->workspace = nullptr;
 
 #ifdef XWAYLAND
     // commit is per-surface with xwayland
@@ -275,6 +310,7 @@ void Toplevel::unmap_notify(wl_listener *listener,
         wl_list_remove(&toplevel->foreign_activate.link);
         wl_list_remove(&toplevel->foreign_close.link);
         wlr_foreign_toplevel_handle_v1_destroy(toplevel->foreign_handle);
+        toplevel->foreign_handle = nullptr;
     }
 
     // remove ext foreign handle
@@ -282,8 +318,14 @@ void Toplevel::unmap_notify(wl_listener *listener,
         wl_list_remove(&toplevel->ext_foreign_destroy.link);
         wlr_ext_foreign_toplevel_handle_v1_destroy(
             toplevel->ext_foreign_handle);
+        toplevel->ext_foreign_handle = nullptr;
     }
 
+    // drop a pending rule check
+    if (toplevel->rule_timer)
+        wl_event_source_timer_update(toplevel->rule_timer, 0);
+    toplevel->rule_fields = 0;
+
     // remove reference
     toplevel->image_capture_surface = nullptr;
 
@@ -329,11 +371,8 @@ Toplevel::Toplevel(Server *server, wlr_xdg_toplevel *xdg_toplevel)
         }
 
         // handle commit if part of transaction
-        if (toplevel->in_transaction) {
-            Transaction *txn = toplevel->server->transaction_manager->current();
-            if (txn && txn->contains(toplevel))
-                txn->handle_commit(toplevel);
-        }
+        if (toplevel->in_transaction && toplevel->transaction)
+            toplevel->transaction->handle_commit(toplevel);
     };
     wl_signal_add(&xdg_toplevel->base->surface->events.commit, &commit);
 
@@ -350,10 +389,8 @@ Toplevel::Toplevel(Server *server, wlr_xdg_toplevel *xdg_toplevel)
     // xdg_toplevel_destroy
     destroy.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
         Toplevel *toplevel = wl_container_of(listener, toplevel, destroy);
-        if (toplevel->in_transaction && toplevel->server->transaction_manager) {
+        if (toplevel->transaction && toplevel->server->transaction_manager)
             toplevel->server->transaction_manager->remove_toplevel(toplevel);
-            toplevel->in_transaction = false;
-        }
         delete toplevel;
     };
     wl_signal_add(&xdg_toplevel->events.destroy, &destroy);
@@ -437,16 +474,16 @@ Toplevel::Toplevel(Server *server, wlr_xdg_toplevel *xdg_toplevel)
     wl_signal_add(&xdg_toplevel->events.request_minimize, &request_minimize);
 
     // set_title
-    set_title.notify = []([[maybe_unused]] wl_listener *listener,
-                          [[maybe_unused]] void *data) {
-        // noop
+    set_title.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
+        Toplevel *toplevel = wl_container_of(listener, toplevel, set_title);
+        toplevel->update_title();
     };
     wl_signal_add(&xdg_toplevel->events.set_title, &set_title);
 
     // set_app_id
-    set_app_id.notify = []([[maybe_unused]] wl_listener *listener,
-                           [[maybe_unused]] void *data) {
-        // noop
+    set_app_id.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
+        Toplevel *toplevel = wl_container_of(listener, toplevel, set_app_id);
+        toplevel->update_app_id();
     };
     wl_signal_add(&xdg_toplevel->events.set_app_id, &set_app_id);
 }
@@ -464,6 +501,8 @@ Toplevel::~Toplevel() {
         wl_list_remove(&xwayland_maximize.link);
         wl_list_remove(&xwayland_fullscreen.link);
         wl_list_remove(&xwayland_close.link);
+        wl_list_remove(&set_title.link);
+        wl_list_remove(&set_app_id.link);
     } else {
 #endif
         wl_list_remove(&map.link);
@@ -491,7 +530,13 @@ Toplevel::~Toplevel() {
         delete activation_token;
     }
 
+    if (rule_timer)
+        wl_event_source_remove(rule_timer);
+
     if (!server->shutting_down) {
+        // the surface may outlive its role
+        server->cursor->invalidate_hit();
+
 #ifdef XWAYLAND
         if (xwayland_surface && scene_tree) {
             wlr_scene_node_destroy(&scene_tree->node);
@@ -526,10 +571,8 @@ Toplevel::Toplevel(Server *server, wlr_xwayland_surface *xwayland_surface)
     // destroy
     destroy.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
         Toplevel *toplevel = wl_container_of(listener, toplevel, destroy);
-        if (toplevel->in_transaction && toplevel->server->transaction_manager) {
+        if (toplevel->transaction && toplevel->server->transaction_manager)
             toplevel->server->transaction_manager->remove_toplevel(toplevel);
-            toplevel->in_transaction = false;
-        }
         delete toplevel;
     };
     wl_signal_add(&xwayland_surface->events.destroy, &destroy);
@@ -671,6 +714,20 @@ Toplevel::Toplevel(Server *server, wlr_xwayland_surface *xwayland_surface)
         toplevel->close();
     };
     wl_signal_add(&xwayland_surface->events.request_close, &xwayland_close);
+
+    // set_title
+    set_title.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
+        Toplevel *toplevel = wl_container_of(listener, toplevel, set_title);
+        toplevel->update_title();
+    };
+    wl_signal_add(&xwayland_surface->events.set_title, &set_title);
+
+    // set_class, the class stands in for the app id
+    set_app_id.notify = [](wl_listener *listener, [[maybe_unused]] void *data) {
+        Toplevel *toplevel = wl_container_of(listener, toplevel, set_app_id);
+        toplevel->update_app_id();
+    };
+    wl_signal_add(&xwayland_surface->events.set_class, &set_app_id);
 }
 #endif
 
@@ -731,6 +788,11 @@ void Toplevel::focus() const {
 
         // move toplevel node to top of scene tree
         wlr_scene_node_raise_to_top(&scene_tree->node);
+        server->cursor->invalidate_hit();
+
+        // a raised fullscreen toplevel covers the others
+        if (actual_fullscreen && workspace)
+            workspace->schedule_visibility();
 
         // activate toplevel
         if (xdg_toplevel)
@@ -881,6 +943,15 @@ void Toplevel::set_position_size(double x, double y, int width, int height) {
         height = 1;
     }
 
+    // the titlebar and IPC clients only hear about a box that changed, or a
+    // toplevel that leaves a state or is shown for the first time
+    const wlr_box box{static_cast<int>(x), static_cast<int>(y), width, height};
+    const bool changed = box.x != geometry.x || box.y != geometry.y ||
+                         box.width != geometry.width ||
+                         box.height != geometry.height ||
+                         scene_hidden_for_autotile || maximized() ||
+                         fullscreen();
+
     // toggle maximized if maximized
     if (maximized()) {
 #ifdef XWAYLAND
@@ -911,7 +982,8 @@ void Toplevel::set_position_size(double x, double y, int width, int height) {
             decoration->set_visible(true);
 
         // move scene tree node to toplevel tree
-        wlr_scene_node_reparent(&scene_tree->node, server->layers.floating);
+        wlr_scene_node_reparent(&scene_tree->node, layer_tree());
+        server->cursor->invalidate_hit();
 
         // restore surface fullscreen state if disable_decorations is enabled
         if (server->config->general.disable_decorations) {
@@ -925,12 +997,18 @@ void Toplevel::set_position_size(double x, double y, int width, int height) {
     }
 
     // store the original geometry (without decoration offset) for later use
-    geometry = wlr_box{static_cast<int>(x), static_cast<int>(y), width, height};
+    set_geometry(box);
+    if (workspace && workspace->bsp_tree)
+        workspace->bsp_tree->check_leaf(this);
 
     // re-enable scene node if it was disabled for auto-tile positioning
     if (scene_hidden_for_autotile) {
         wlr_scene_node_set_enabled(&scene_tree->node, true);
         scene_hidden_for_autotile = false;
+        server->cursor->invalidate_hit();
+
+        if (workspace)
+            workspace->schedule_visibility();
     }
 
     // apply decoration offset if decoration is visible
@@ -949,21 +1027,33 @@ void Toplevel::set_position_size(double x, double y, int width, int height) {
         // set new position
         wlr_scene_node_set_position(&scene_tree->node, x, y);
 
-        // set position and size
-        wlr_xdg_toplevel_set_size(xdg_toplevel, width, height);
+        // only configure if the size changes, moves are compositor side
+        if (xdg_toplevel->scheduled.width != width ||
+            xdg_toplevel->scheduled.height != height) {
+            // set position and size
+            wlr_xdg_toplevel_set_size(xdg_toplevel, width, height);
 
-        // schedule configure
-        wlr_xdg_surface_schedule_configure(xdg_toplevel->base);
+            // schedule configure
+            wlr_xdg_surface_schedule_configure(xdg_toplevel->base);
+        }
 #ifdef XWAYLAND
     } else {
         // set scene node position
         wlr_scene_node_set_position(&scene_surface->buffer->node, x, y);
 
-        // schedule configure
-        wlr_xwayland_surface_configure(xwayland_surface, x, y, width, height);
+        // schedule configure, unless the surface already has this box
+        if (xwayland_surface->x != static_cast<int>(x) ||
+            xwayland_surface->y != static_cast<int>(y) ||
+            xwayland_surface->width != width ||
+            xwayland_surface->height != height)
+            wlr_xwayland_surface_configure(xwayland_surface, x, y, width,
+                                           height);
     }
 #endif
 
+    if (!changed)
+        return;
+
     if (decoration)
         decoration->update_titlebar(geometry.width);
 
@@ -985,29 +1075,76 @@ void Toplevel::set_decoration_mode(wlr_xdg_toplevel_decoration_v1_mode mode) {
     decoration_mode = mode;
 }
 
+// geometry the toplevel has, or will have once its transaction applies
+wlr_box Toplevel::target_geometry() const {
+    if (transaction)
+        return transaction->pending_changes[transaction_slot].geometry;
+
+    return geometry;
+}
+
+// store the geometry, spatial queries are only invalidated if it changed
+void Toplevel::set_geometry(const wlr_box &box) {
+    if (geometry.x == box.x && geometry.y == box.y &&
+        geometry.width == box.width && geometry.height == box.height)
+        return;
+
+    geometry = box;
+    if (workspace)
+        workspace->geometry_changed();
+    else
+        ++server->geometry_serial;
+}
+
 // get the geometry of the toplevel
 wlr_box Toplevel::get_geometry() {
 #ifdef XWAYLAND
     if (xdg_toplevel) {
 #endif
-        geometry.x = scene_tree->node.x;
-        geometry.y = scene_tree->node.y;
-        geometry.width = xdg_toplevel->base->surface->current.width;
-        geometry.height = xdg_toplevel->base->surface->current.height;
+        set_geometry({scene_tree->node.x, scene_tree->node.y,
+                      xdg_toplevel->base->surface->current.width,
+                      xdg_toplevel->base->surface->current.height});
 
         // this is called lying
         return xdg_toplevel->base->geometry;
 #ifdef XWAYLAND
     } else {
-        geometry.x = xwayland_surface->x;
-        geometry.y = xwayland_surface->y;
-        geometry.width = xwayland_surface->surface->current.width;
-        geometry.height = xwayland_surface->surface->current.height;
+        set_geometry({xwayland_surface->x, xwayland_surface->y,
+                      xwayland_surface->surface->current.width,
+                      xwayland_surface->surface->current.height});
         return geometry;
     }
 #endif
 }
 
+// get the scene tree this toplevel belongs in, the layers of its workspace
+// if it has one
+wlr_scene_tree *Toplevel::layer_tree() const {
+    if (workspace)
+        return actual_fullscreen ? workspace->layers.fullscreen
+                                 : workspace->layers.floating;
+
+    return actual_fullscreen ? server->layers.fullscreen
+                             : server->layers.floating;
+}
+
+// tell the client whether it is visible at all, x11 has no such state
+void Toplevel::set_suspended(const bool suspended) {
+    if (this->suspended == suspended)
+        return;
+
+#ifdef XWAYLAND
+    if (!xdg_toplevel)
+        return;
+#endif
+
+    if (!xdg_toplevel->base->initialized)
+        return;
+
+    this->suspended = suspended;
+    wlr_xdg_toplevel_set_suspended(xdg_toplevel, suspended);
+}
+
 // set the visibility of the toplevel
 void Toplevel::set_hidden(const bool hidden) {
     this->hidden = hidden;
@@ -1020,6 +1157,7 @@ void Toplevel::set_hidden(const bool hidden) {
     else
         wlr_scene_node_set_enabled(&scene_surface->buffer->node, !hidden);
 #endif
+    server->cursor->invalidate_hit();
 
     if (server->ipc)
         server->ipc->notify_clients(IPC_TOPLEVEL_LIST);
@@ -1037,6 +1175,19 @@ bool Toplevel::maximized() const {
 #endif
 }
 
+// returns true if the toplevel has been asked to maximize, before the client
+// commits it
+bool Toplevel::requested_maximized() const {
+#ifdef XWAYLAND
+    if (xdg_toplevel)
+#endif
+        return xdg_toplevel->scheduled.maximized;
+#ifdef XWAYLAND
+    else
+        return xwayland_maximized;
+#endif
+}
+
 // returns true if the toplevel is fullscreen
 bool Toplevel::fullscreen() const { return actual_fullscreen; };
 
@@ -1057,16 +1208,21 @@ void Toplevel::set_fullscreen(const bool fullscreen) {
     // update actual fullscreen state
     actual_fullscreen = fullscreen;
 
-    // get output from toplevel's current workspace, fallback to focused output
+    // get output from toplevel's current workspace, fallback to focused
+    // output when the workspace is missing or orphaned
     Output *output = nullptr;
-    Workspace *workspace = server->get_workspace(this);
-    if (workspace)
-        output = workspace->output;
+    Workspace *current = server->get_workspace(this);
+    if (current && current->output)
+        output = current->output;
     else {
         output = server->focused_output();
-        workspace = server->workspace_manager->get_active_workspace(output);
+        current = server->workspace_manager->get_active_workspace(output);
     }
 
+    // fullscreen toplevels suspend what they cover
+    if (current)
+        current->schedule_visibility();
+
     // get output geometry
     const wlr_box output_box = output->layout_geometry;
 
@@ -1087,7 +1243,8 @@ void Toplevel::set_fullscreen(const bool fullscreen) {
 
         // move scene tree node to fullscreen tree
         wlr_scene_node_raise_to_top(&scene_tree->node);
-        wlr_scene_node_reparent(&scene_tree->node, server->layers.fullscreen);
+        wlr_scene_node_reparent(&scene_tree->node, layer_tree());
+        server->cursor->invalidate_hit();
 
         // set to top left of output, width and height the size of output
         set_position_size(output_box.x, output_box.y, output_box.width,
@@ -1099,17 +1256,18 @@ void Toplevel::set_fullscreen(const bool fullscreen) {
             decoration->set_visible(true);
 
         // move scene tree node to toplevel tree
-        wlr_scene_node_reparent(&scene_tree->node, server->layers.floating);
+        wlr_scene_node_reparent(&scene_tree->node, layer_tree());
 
         // raise to top to maintain focus order when transitioning from
         // fullscreen
         wlr_scene_node_raise_to_top(&scene_tree->node);
+        server->cursor->invalidate_hit();
 
         // check if we need to handle auto-tiling
         // Always return to auto-tile when unfullscreening, even if maximized
-        bool should_auto_tile = workspace && workspace->auto_tile;
+        bool should_auto_tile = current && current->auto_tile;
 
-        if (should_auto_tile && workspace->bsp_tree) {
+        if (should_auto_tile && current->bsp_tree) {
             // Un-maximize if currently maximized
             if (maximized()) {
 #ifdef XWAYLAND
@@ -1126,13 +1284,13 @@ void Toplevel::set_fullscreen(const bool fullscreen) {
             }
 
             // re-insert into BSP tree if it's not already there
-            if (!workspace->bsp_tree->find_node(this)) {
-                workspace->bsp_tree->insert(this);
+            if (!current->bsp_tree->find_node(this)) {
+                current->bsp_tree->insert(this);
             }
 
             // apply BSP tree layout
             wlr_box new_geometry;
-            if (workspace->bsp_tree->get_toplevel_geometry(
+            if (current->bsp_tree->get_toplevel_geometry(
                     this, output->usable_area, new_geometry)) {
                 set_position_size(new_geometry);
             } else {
@@ -1220,36 +1378,20 @@ void Toplevel::set_maximized(const bool maximized) {
 
         // re-tile remaining windows if in auto-tile workspace
         if (workspace && workspace->auto_tile && workspace->bsp_tree) {
-            // cancel any pending layout operations
-            if (workspace->pending_layout_idle) {
-                wl_event_source_remove(workspace->pending_layout_idle);
-                workspace->pending_layout_idle = nullptr;
-            }
-
             // remove this toplevel from BSP tree
             workspace->bsp_tree->remove(this);
-
-            // immediately apply layout synchronously instead of using idle
-            // callback
-            workspace->bsp_tree->apply_layout(workspace->output->usable_area);
+            workspace->schedule_layout();
         }
     } else {
         // check if we need to handle auto-tiling
         bool should_auto_tile = workspace && workspace->auto_tile;
 
         if (should_auto_tile && workspace->bsp_tree) {
-            // cancel any pending layout operations
-            if (workspace->pending_layout_idle) {
-                wl_event_source_remove(workspace->pending_layout_idle);
-                workspace->pending_layout_idle = nullptr;
-            }
-
             // re-insert into BSP tree if it's not already there
             if (!workspace->bsp_tree->find_node(this))
                 workspace->bsp_tree->insert(this);
 
-            // immediately apply layout synchronously
-            workspace->bsp_tree->apply_layout(workspace->output->usable_area);
+            workspace->schedule_layout();
         } else {
             // handles edge case where toplevel starts maximized
             if (saved_geometry.width && saved_geometry.height)
@@ -1405,6 +1547,8 @@ void Toplevel::update_title() {
 
     if (ext_foreign_handle)
         update_ext_foreign();
+
+    rule_field_changed(WINDOW_RULE_TITLE);
 }
 
 // update the app id of the toplevel
@@ -1416,6 +1560,71 @@ void Toplevel::update_app_id() {
 
     if (ext_foreign_handle)
         update_ext_foreign();
+
+    rule_field_changed(WINDOW_RULE_CLASS);
+}
+
+// update the tag of the toplevel
+void Toplevel::update_tag(const char *tag) {
+    this->tag = tag ? tag : "";
+    rule_field_changed(WINDOW_RULE_TAG);
+}
+
+// schedule a window rule check after a field rules can match on changed
+void Toplevel::rule_field_changed(const uint8_t field) {
+    // rules are applied at map, and only fields some rule looks at matter
+    if (!(server->config->rule_index.fields & field))
+        return;
+
+    // workspaces of an unplugged output have nowhere to move a toplevel to
+    const Workspace *current = server->get_workspace(this);
+    if (!current || !current->output)
+        return;
+
+    // a check is already pending
+    const bool pending = rule_fields;
+    rule_fields |= field;
+    if (pending)
+        return;
+
+    if (!rule_timer)
+        rule_timer = wl_event_loop_add_timer(
+            server->event_loop,
+            [](void *data) {
+                static_cast<Toplevel *>(data)->check_rules();
+                return 0;
+            },
+            this);
+
+    wl_event_source_timer_update(rule_timer, RULE_CHECK_DELAY_MS);
+}
+
+// apply the first matching window rule if it is not the one matched before,
+// a toplevel leaving a rule keeps what the rule did
+void Toplevel::check_rules() {
+    const uint8_t changed = rule_fields;
+    rule_fields = 0;
+
+    if (!changed)
+        return;
+
+    Workspace *current = server->get_workspace(this);
+    if (!current || !current->output)
+        return;
+
+    const WindowRuleIndex &rule_index = server->config->rule_index;
+    const int32_t next = rule_index.recheck(this, rule, changed);
+    if (next == rule)
+        return;
+
+    rule = next;
+    if (next < 0)
+        return;
+
+    // the move and the state changes land in one frame
+    server->transaction_manager->begin();
+    rule_index.rules[next]->reapply(this, current);
+    server->transaction_manager->commit();
 }
 
 // tell the toplevel to close
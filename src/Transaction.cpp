@@ -1,27 +1,40 @@
 #include "Transaction.h"
+#include "BSPTree.h"
 #include "Server.h"
 #include "Toplevel.h"
 #include "Workspace.h"
 
 constexpr int TRANSACTION_TIMEOUT_MS = 300; // constexpr so fancy
+constexpr size_t TRANSACTION_INITIAL_CAPACITY = 64;
+
 Transaction::Transaction(Server *server) : server(server) {
     surface_commit.notify = nullptr;
+
+    // capacity is kept across reuse so steady state tiling does not allocate
+    pending_changes.reserve(TRANSACTION_INITIAL_CAPACITY);
 }
 
-Transaction::~Transaction() { cleanup(); }
+Transaction::~Transaction() {
+    cleanup();
+
+    if (timeout_timer)
+        wl_event_source_remove(timeout_timer);
+}
 
 void Transaction::add_change(Toplevel *toplevel, const wlr_box &geometry) {
     if (!toplevel)
         return;
 
     // check for already pending change
-    for (auto &pending : pending_changes) {
-        if (pending.toplevel == toplevel) {
-            pending.geometry = geometry;
-            return;
-        }
+    if (toplevel->transaction == this) {
+        pending_changes[toplevel->transaction_slot].geometry = geometry;
+        return;
     }
 
+    // newer geometry supersedes any older in-flight transaction
+    if (toplevel->transaction)
+        toplevel->transaction->remove_toplevel(toplevel);
+
     // add new pending change
     PendingGeometry pending;
     pending.toplevel = toplevel;
@@ -29,6 +42,8 @@ void Transaction::add_change(Toplevel *toplevel, const wlr_box &geometry) {
     pending.serial = 0;
     pending.committed = false;
 
+    toplevel->transaction = this;
+    toplevel->transaction_slot = pending_changes.size();
     pending_changes.push_back(pending);
 }
 
@@ -50,14 +65,8 @@ void Transaction::commit() {
     for (auto &pending : pending_changes) {
         Toplevel *toplevel = pending.toplevel;
         const wlr_box &geo = pending.geometry;
-
-        // store pending geometry
-        toplevel->pending_transaction_geometry = geo;
-        toplevel->in_transaction = true;
-
-        // update decoration before toplevel
-        if (toplevel->decoration)
-            toplevel->decoration->update_titlebar(geo.width);
+        if (!toplevel)
+            continue;
 
         int width = geo.width;
         int height = geo.height;
@@ -71,8 +80,53 @@ void Transaction::commit() {
             height -= deco_height;
         }
 
+        // a configure is only needed if the size changes
+        bool resize = true;
+#ifdef XWAYLAND
+        if (toplevel->xdg_toplevel) {
+#endif
+            const wlr_xdg_toplevel_configure &scheduled =
+                toplevel->xdg_toplevel->scheduled;
+            resize = scheduled.width != width || scheduled.height != height;
+#ifdef XWAYLAND
+        } else if (toplevel->xwayland_surface) {
+            resize = toplevel->xwayland_surface->width != width ||
+                     toplevel->xwayland_surface->height != height;
+        }
+#endif
+
+        // drop toplevels that are already where they should be
+        if (!resize && !toplevel->scene_hidden_for_autotile &&
+            wlr_box_equal(&toplevel->geometry, &geo)) {
+            pending.committed = true;
+            pending.toplevel = nullptr;
+            toplevel->transaction = nullptr;
+            continue;
+        }
+
+        // store pending geometry
+        toplevel->pending_transaction_geometry = geo;
+        toplevel->in_transaction = true;
+
+        // update decoration before toplevel
+        if (toplevel->decoration)
+            toplevel->decoration->update_titlebar(geo.width);
+
         if (width <= 0 || height <= 0) {
-            waiting_for_commit.erase(toplevel);
+            pending.committed = true;
+            continue;
+        }
+
+#ifdef XWAYLAND
+        // x11 windows are told about their position as well
+        if (toplevel->xwayland_surface)
+            wlr_xwayland_surface_configure(toplevel->xwayland_surface, geo.x,
+                                           geo.y, width, height);
+#endif
+
+        // position only changes are applied without waiting for the client
+        if (!resize) {
+            pending.committed = true;
             continue;
         }
 
@@ -83,17 +137,14 @@ void Transaction::commit() {
                                                        width, height);
             wlr_xdg_surface_schedule_configure(toplevel->xdg_toplevel->base);
 #ifdef XWAYLAND
-        } else if (toplevel->xwayland_surface) {
-            wlr_xwayland_surface_configure(toplevel->xwayland_surface, geo.x,
-                                           geo.y, width, height);
-            pending.serial = 0;
         }
 #endif
 
-        waiting_for_commit.insert(toplevel);
+        ++waiting_for_commit;
     }
 
-    setup_timeout();
+    if (waiting_for_commit)
+        setup_timeout();
 }
 
 void Transaction::apply() {
@@ -170,10 +221,14 @@ void Transaction::apply() {
         if (toplevel->scene_hidden_for_autotile) {
             wlr_scene_node_set_enabled(&toplevel->scene_tree->node, true);
             toplevel->scene_hidden_for_autotile = false;
+            server->cursor->invalidate_hit();
+            workspace->schedule_visibility();
         }
 
-        toplevel->geometry = geo;
+        toplevel->set_geometry(geo);
         toplevel->in_transaction = false;
+        if (workspace->bsp_tree)
+            workspace->bsp_tree->check_leaf(toplevel);
 
         int x = geo.x;
         int y = geo.y;
@@ -208,82 +263,86 @@ void Transaction::apply() {
 }
 
 bool Transaction::contains(Toplevel *toplevel) const {
-    for (const auto &pending : pending_changes) {
-        if (pending.toplevel == toplevel)
-            return true;
-    }
-    return false;
+    return toplevel && toplevel->transaction == this;
 }
 
 void Transaction::handle_commit(Toplevel *toplevel) {
-    if (!contains(toplevel))
+    if (!committed || !contains(toplevel))
         return;
 
     // mark toplevel as committed
-    for (auto &pending : pending_changes) {
-        if (pending.toplevel == toplevel) {
-            pending.committed = true;
-            break;
-        }
-    }
+    PendingGeometry &pending = pending_changes[toplevel->transaction_slot];
+    if (pending.committed)
+        return;
 
-    // remove from waiting set
-    waiting_for_commit.erase(toplevel);
+    pending.committed = true;
+    --waiting_for_commit;
 
     // apply transaction
-    if (waiting_for_commit.empty()) {
-        if (server->transaction_manager->current() == this) {
-            server->transaction_manager->active_transaction = nullptr;
-        }
-        apply();
-        delete this;
-    }
+    if (!waiting_for_commit)
+        finish();
 }
 
 void Transaction::remove_toplevel(Toplevel *toplevel) {
-    if (!toplevel)
+    if (!contains(toplevel))
         return;
 
-    // remove from waiting set
-    waiting_for_commit.erase(toplevel);
-
     // mark as removed in pending changes
-    for (auto &pending : pending_changes)
-        if (pending.toplevel == toplevel)
-            pending.toplevel = nullptr;
+    PendingGeometry &pending = pending_changes[toplevel->transaction_slot];
+    if (committed && !pending.committed)
+        --waiting_for_commit;
+
+    pending.committed = true;
+    pending.toplevel = nullptr;
+
+    toplevel->transaction = nullptr;
+    toplevel->in_transaction = false;
 
     // apply transaction
-    if (committed && waiting_for_commit.empty() && !pending_changes.empty()) {
-        if (server->transaction_manager->current() == this) {
-            server->transaction_manager->active_transaction = nullptr;
-        }
-        apply();
-        delete this;
-    }
+    if (committed && !waiting_for_commit && !pending_changes.empty())
+        finish();
 }
 
-void Transaction::setup_timeout() {
-    if (timeout_timer)
-        wl_event_source_remove(timeout_timer);
+void Transaction::reset() {
+    cleanup();
 
-    timeout_timer = wl_event_loop_add_timer(
-        wl_display_get_event_loop(server->display), on_timeout, this);
+    pending_changes.clear();
+    committed = false;
+}
+
+void Transaction::setup_timeout() {
+    // the timer source is kept for the lifetime of the transaction object
+    if (!timeout_timer)
+        timeout_timer = wl_event_loop_add_timer(
+            wl_display_get_event_loop(server->display), on_timeout, this);
 
     wl_event_source_timer_update(timeout_timer, TRANSACTION_TIMEOUT_MS);
 }
 
 void Transaction::cleanup() {
-    if (timeout_timer) {
-        wl_event_source_remove(timeout_timer);
-        timeout_timer = nullptr;
-    }
+    // disarm timer
+    if (timeout_timer)
+        wl_event_source_timer_update(timeout_timer, 0);
 
-    waiting_for_commit.clear();
+    waiting_for_commit = 0;
 
     // clear transaction state
-    for (const auto &pending : pending_changes)
-        if (pending.toplevel)
+    for (auto &pending : pending_changes)
+        if (pending.toplevel && pending.toplevel->transaction == this) {
             pending.toplevel->in_transaction = false;
+            pending.toplevel->transaction = nullptr;
+            pending.toplevel = nullptr;
+        }
+}
+
+// apply and hand the transaction back to the manager
+void Transaction::finish() {
+    TransactionManager *manager = server->transaction_manager;
+    if (manager->current() == this)
+        manager->active_transaction = nullptr;
+
+    apply();
+    manager->release(this);
 }
 
 int Transaction::on_timeout(void *data) {
@@ -291,12 +350,7 @@ int Transaction::on_timeout(void *data) {
     if (!txn)
         return 0;
 
-    if (txn->server->transaction_manager->current() == txn)
-        txn->server->transaction_manager->active_transaction = nullptr;
-
-    txn->apply();
-
-    delete txn;
+    txn->finish();
     return 0;
 }
 
@@ -309,13 +363,29 @@ TransactionManager::~TransactionManager() {
         active_transaction->apply();
         delete active_transaction;
     }
+
+    for (Transaction *txn : pool)
+        delete txn;
 }
 
 Transaction *TransactionManager::begin() {
+    // join the open transaction
+    if (active_transaction && !active_transaction->committed) {
+        ++depth;
+        return active_transaction;
+    }
+
     if (active_transaction)
         commit();
 
-    active_transaction = new Transaction(server);
+    // reuse a finished transaction if possible
+    if (pool.empty())
+        active_transaction = new Transaction(server);
+    else {
+        active_transaction = pool.back();
+        pool.pop_back();
+    }
+
     return active_transaction;
 }
 
@@ -323,19 +393,32 @@ void TransactionManager::commit() {
     if (!active_transaction)
         return;
 
+    // an outer begin owns the commit
+    if (depth) {
+        --depth;
+        return;
+    }
+
     Transaction *txn = active_transaction;
 
     txn->commit();
 
-    if (txn->pending_changes.empty()) {
+    // nothing to wait for, apply right away
+    if (!txn->waiting_for_commit) {
         active_transaction = nullptr;
-        delete txn;
+        txn->apply();
+        release(txn);
     }
 }
 
 void TransactionManager::remove_toplevel(Toplevel *toplevel) {
-    if (active_transaction)
-        active_transaction->remove_toplevel(toplevel);
+    if (toplevel && toplevel->transaction)
+        toplevel->transaction->remove_toplevel(toplevel);
+}
+
+void TransactionManager::release(Transaction *txn) {
+    txn->reset();
+    pool.push_back(txn);
 }
 
 // idfk
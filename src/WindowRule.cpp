@@ -4,14 +4,68 @@
 #include "Server.h"
 #include "Toplevel.h"
 #include "Workspace.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// split off the literal part of a pattern, a pattern without special
+// characters is matched by string comparison alone
+RulePattern::RulePattern(const std::string &pattern) : kind(LITERAL) {
+    static const char special[] = "^$\\.*+?()[]{}|";
+    auto is_special = [](char c) { return c && std::strchr(special, c); };
+
+    // a quantifier applies to the character before it
+    auto quantified = [&](size_t i) {
+        return i < pattern.size() && (pattern[i] == '*' || pattern[i] == '+' ||
+                                      pattern[i] == '?' || pattern[i] == '{');
+    };
+
+    size_t i = 0;
+    while (i != pattern.size()) {
+        // escaped punctuation stands for itself
+        if (pattern[i] == '\\' && i + 1 < pattern.size() &&
+            std::ispunct(static_cast<unsigned char>(pattern[i + 1]))) {
+            if (quantified(i + 2))
+                break;
+            literal += pattern[i + 1];
+            i += 2;
+            continue;
+        }
+
+        if (is_special(pattern[i]) || quantified(i + 1))
+            break;
+        literal += pattern[i++];
+    }
+
+    if (i == pattern.size())
+        return;
+
+    // any alternative can do without the prefix
+    if (pattern.find('|') != std::string::npos)
+        literal.clear();
+
+    kind = literal.empty() ? REGEX : PREFIX;
+    re = std::regex(pattern);
+}
+
+bool RulePattern::matches(std::string_view subject) const {
+    switch (kind) {
+    case LITERAL:
+        return subject == literal;
+    case PREFIX:
+        if (subject.substr(0, literal.size()) != literal)
+            return false;
+        [[fallthrough]];
+    default:
+        return std::regex_match(subject.begin(), subject.end(), re);
+    }
+}
 
 WindowRule::WindowRule(std::string title_match, std::string class_match,
                        std::string tag_match, uint8_t matches_present)
     : title(title_match), class_(class_match), tag(tag_match),
-      title_re(std::regex(title_match)), class_re(std::regex(class_match)),
-      tag_re(std::regex(tag_match)), matches_present(matches_present) {
-    geometry = new wlr_box;
-}
+      title_pattern(title_match), class_pattern(class_match),
+      tag_pattern(tag_match), matches_present(matches_present) {}
 
 WindowRule::~WindowRule() {
     if (toplevel_state)
@@ -19,17 +73,80 @@ WindowRule::~WindowRule() {
     delete geometry;
 }
 
+// rules are equal if they match and do the same
+bool WindowRule::operator==(const WindowRule &other) const {
+    if (!toplevel_state != !other.toplevel_state ||
+        (toplevel_state && *toplevel_state != *other.toplevel_state))
+        return false;
+
+    return title == other.title && class_ == other.class_ &&
+           tag == other.tag && matches_present == other.matches_present &&
+           workspace == other.workspace && output == other.output &&
+           pinned == other.pinned && floating == other.floating &&
+           tiling_mode == other.tiling_mode &&
+           wlr_box_equal(geometry, other.geometry);
+}
+
 // see if toplevel matches window rule
-bool WindowRule::matches(Toplevel *toplevel) {
-    bool match = true;
-    if (matches_present & WINDOW_RULE_TITLE)
-        match &= std::regex_match(std::string(toplevel->get_title()), title_re);
-    if (matches_present & WINDOW_RULE_CLASS)
-        match &=
-            std::regex_match(std::string(toplevel->get_app_id()), class_re);
-    if (matches_present & WINDOW_RULE_TAG)
-        match &= std::regex_match(toplevel->tag, tag_re);
-    return match;
+bool WindowRule::matches(Toplevel *toplevel) const {
+    return matches(toplevel->get_app_id(), toplevel->get_title(),
+                   toplevel->tag);
+}
+
+bool WindowRule::matches(std::string_view app_id, std::string_view title,
+                         std::string_view tag) const {
+    if ((matches_present & WINDOW_RULE_CLASS) && !class_pattern.matches(app_id))
+        return false;
+    if ((matches_present & WINDOW_RULE_TITLE) && !title_pattern.matches(title))
+        return false;
+    if ((matches_present & WINDOW_RULE_TAG) && !tag_pattern.matches(tag))
+        return false;
+    return true;
+}
+
+// determine if toplevel should be floating
+bool WindowRule::floats(Toplevel *toplevel) const {
+    switch (tiling_mode) {
+    case TILING_MODE_FLOATING:
+    case TILING_MODE_TILING:
+        return true;
+    case TILING_MODE_AUTO:
+        return floating || toplevel->should_be_floating();
+    default:
+        return false;
+    }
+}
+
+// floating, maximized and fullscreen toplevels stay out of the tiling
+bool WindowRule::skips_auto_tile(bool floating) const {
+    return floating ||
+           (toplevel_state &&
+            (*toplevel_state == XDG_TOPLEVEL_STATE_MAXIMIZED ||
+             *toplevel_state == XDG_TOPLEVEL_STATE_FULLSCREEN));
+}
+
+// set the pinned state, geometry and toplevel state of the rule
+void WindowRule::set_state(Toplevel *toplevel) const {
+    // set toplevel pinned state
+    toplevel->pinned = pinned;
+
+    // set toplevel geometry
+    if (geometry)
+        toplevel->set_position_size(*geometry);
+
+    // set toplevel state
+    if (toplevel_state)
+        switch (*toplevel_state) {
+        case XDG_TOPLEVEL_STATE_MAXIMIZED:
+            toplevel->set_maximized(true);
+            break;
+        case XDG_TOPLEVEL_STATE_FULLSCREEN:
+            toplevel->set_fullscreen(true);
+            break;
+        default:
+            wlr_log(WLR_INFO, "Unhandled toplevel state %d", *toplevel_state);
+            break;
+        }
 }
 
 // apply each Rule in the WindowRule to a toplevel
@@ -48,31 +165,12 @@ void WindowRule::apply(Toplevel *toplevel) {
                                       ? target_output->get_workspace(workspace)
                                       : target_output->get_active();
 
-    // determine if toplevel should be floating
-    bool should_be_floating = false;
-    switch (tiling_mode) {
-    case TILING_MODE_FLOATING:
-    case TILING_MODE_TILING:
-        should_be_floating = true;
-        break;
-    case TILING_MODE_AUTO:
-        should_be_floating = floating;
-        if (!should_be_floating)
-            should_be_floating = toplevel->should_be_floating();
-    default:
-        break;
-    }
-
     // set toplevel floating state
+    const bool should_be_floating = floats(toplevel);
     toplevel->is_floating = should_be_floating;
 
     // set toplevel workspace
-    bool should_skip_auto_tile = should_be_floating;
-    if (toplevel_state)
-        should_skip_auto_tile =
-            should_skip_auto_tile ||
-            (*toplevel_state == XDG_TOPLEVEL_STATE_MAXIMIZED) ||
-            (*toplevel_state == XDG_TOPLEVEL_STATE_FULLSCREEN);
+    const bool should_skip_auto_tile = skips_auto_tile(should_be_floating);
 
     bool workspace_auto_tile = target_workspace->auto_tile;
     if (should_skip_auto_tile && workspace_auto_tile)
@@ -83,27 +181,199 @@ void WindowRule::apply(Toplevel *toplevel) {
     if (should_skip_auto_tile && workspace_auto_tile)
         target_workspace->auto_tile = workspace_auto_tile;
 
-    if (target_output->get_active() != target_workspace)
-        toplevel->set_hidden(true);
+    set_state(toplevel);
+}
+
+// apply a rule to a mapped toplevel that has come to match it, the toplevel
+// is moved from current, which has to be on an output, instead of added and
+// stays on its output unless the rule names one
+void WindowRule::reapply(Toplevel *toplevel, Workspace *current) {
+    Server *server = toplevel->server;
 
-    // set toplevel pinned state
-    toplevel->pinned = pinned;
+    // get target output
+    Output *target_output = output.empty()
+                                ? current->output
+                                : server->output_manager->get_output(output);
+    if (!target_output)
+        target_output = current->output;
 
-    // set toplevel geometry
-    if (geometry)
-        toplevel->set_position_size(*geometry);
+    // get target workspace
+    Workspace *target_workspace = current;
+    if (workspace > 0)
+        target_workspace = target_output->get_workspace(workspace);
+    else if (target_output != current->output)
+        target_workspace = target_output->get_active();
+    if (!target_workspace)
+        target_workspace = current;
 
-    // set toplevel state
-    if (toplevel_state)
-        switch (*toplevel_state) {
-        case XDG_TOPLEVEL_STATE_MAXIMIZED:
-            toplevel->set_maximized(true);
+    // set toplevel floating state
+    const bool should_be_floating = floats(toplevel);
+    const bool floating_changed = toplevel->is_floating != should_be_floating;
+    toplevel->is_floating = should_be_floating;
+
+    if (target_workspace == current) {
+        // the tiling of its own workspace changes with the floating state
+        if (floating_changed && current->auto_tile)
+            current->retile();
+    } else {
+        // move_to takes the toplevel out of the old tiling
+        const bool should_skip_auto_tile = skips_auto_tile(should_be_floating);
+        const bool workspace_auto_tile = target_workspace->auto_tile;
+        if (should_skip_auto_tile && workspace_auto_tile)
+            target_workspace->auto_tile = false;
+
+        current->move_to(toplevel, target_workspace);
+
+        if (should_skip_auto_tile && workspace_auto_tile)
+            target_workspace->auto_tile = workspace_auto_tile;
+    }
+
+    set_state(toplevel);
+}
+
+// index the rules of a config by class
+void WindowRuleIndex::compile(const std::vector<WindowRule *> &window_rules) {
+    rules = window_rules;
+    by_class.clear();
+    by_prefix.clear();
+    by_regex.clear();
+    any_class.clear();
+    with_title.clear();
+    with_tag.clear();
+    has_combined = false;
+    fields = 0;
+
+    // group numbers shift in the combined pattern, so backreferences would
+    // refer to the wrong group
+    auto has_backreference = [](const std::string &pattern) {
+        for (size_t i = 0; i + 1 < pattern.size(); ++i)
+            if (pattern[i] == '\\') {
+                if (pattern[i + 1] >= '1' && pattern[i + 1] <= '9')
+                    return true;
+                ++i;
+            }
+        return false;
+    };
+
+    std::string combined_pattern;
+    bool combinable = true;
+
+    for (uint32_t i = 0; i != rules.size(); ++i) {
+        const WindowRule *rule = rules[i];
+        fields |= rule->matches_present;
+
+        if (rule->matches_present & WINDOW_RULE_TITLE)
+            with_title.push_back(i);
+        if (rule->matches_present & WINDOW_RULE_TAG)
+            with_tag.push_back(i);
+
+        if (!(rule->matches_present & WINDOW_RULE_CLASS)) {
+            any_class.push_back(i);
+            continue;
+        }
+
+        const RulePattern &pattern = rule->class_pattern;
+        switch (pattern.kind) {
+        case RulePattern::LITERAL:
+            by_class[pattern.literal].push_back(i);
             break;
-        case XDG_TOPLEVEL_STATE_FULLSCREEN:
-            toplevel->set_fullscreen(true);
+        case RulePattern::PREFIX:
+            by_prefix.emplace_back(pattern.literal, i);
             break;
-        default:
-            wlr_log(WLR_INFO, "Unhandled toplevel state %d", *toplevel_state);
+        case RulePattern::REGEX:
+            by_regex.push_back(i);
+            combinable &= !has_backreference(rule->class_);
+            if (!combined_pattern.empty())
+                combined_pattern += '|';
+            combined_pattern += "(?:" + rule->class_ + ")";
             break;
         }
+    }
+
+    if (combinable && by_regex.size() > 1) {
+        combined = std::regex(combined_pattern, std::regex::optimize);
+        has_combined = true;
+    }
+}
+
+// add the rules whose class pattern can match an app_id
+void WindowRuleIndex::class_candidates(
+    std::string_view app_id, std::vector<uint32_t> &candidates) const {
+    if (auto it = by_class.find(std::string(app_id)); it != by_class.end())
+        candidates.insert(candidates.end(), it->second.begin(),
+                          it->second.end());
+
+    for (const auto &[prefix, i] : by_prefix)
+        if (app_id.substr(0, prefix.size()) == prefix)
+            candidates.push_back(i);
+
+    if (!by_regex.empty() &&
+        (!has_combined ||
+         std::regex_match(app_id.begin(), app_id.end(), combined)))
+        candidates.insert(candidates.end(), by_regex.begin(), by_regex.end());
+}
+
+// find the index of the first rule in config order that matches a toplevel,
+// -1 if none does
+int32_t WindowRuleIndex::match_index(Toplevel *toplevel) const {
+    return match_index(toplevel->get_app_id(), toplevel->get_title(),
+                       toplevel->tag);
+}
+
+int32_t WindowRuleIndex::match_index(std::string_view app_id,
+                                     std::string_view title,
+                                     std::string_view tag) const {
+    if (rules.empty())
+        return -1;
+
+    std::vector<uint32_t> candidates = any_class;
+    class_candidates(app_id, candidates);
+    std::sort(candidates.begin(), candidates.end());
+
+    for (uint32_t i : candidates)
+        if (rules[i]->matches(app_id, title, tag))
+            return i;
+
+    return -1;
+}
+
+WindowRule *WindowRuleIndex::match(Toplevel *toplevel) const {
+    const int32_t i = match_index(toplevel);
+    return i < 0 ? nullptr : rules[i];
+}
+
+// find the first matching rule again after the fields in changed have
+// changed, previous is the rule that matched before. rules that do not look
+// at a changed field keep their result, so unless the previous rule looks at
+// one only the rules before it that do are checked
+int32_t WindowRuleIndex::recheck(Toplevel *toplevel, int32_t previous,
+                                 uint8_t changed) const {
+    if (previous >= static_cast<int32_t>(rules.size()))
+        return match_index(toplevel);
+
+    if (previous >= 0 && (rules[previous]->matches_present & changed))
+        return match_index(toplevel);
+
+    // rules in any_class do not look at the class
+    std::vector<uint32_t> candidates;
+    if (changed & WINDOW_RULE_CLASS)
+        class_candidates(toplevel->get_app_id(), candidates);
+    if (changed & WINDOW_RULE_TITLE)
+        candidates.insert(candidates.end(), with_title.begin(),
+                          with_title.end());
+    if (changed & WINDOW_RULE_TAG)
+        candidates.insert(candidates.end(), with_tag.begin(), with_tag.end());
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+
+    for (uint32_t i : candidates) {
+        if (previous >= 0 && static_cast<int32_t>(i) >= previous)
+            break;
+        if (rules[i]->matches(toplevel))
+            return i;
+    }
+
+    return previous;
 }
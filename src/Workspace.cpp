@@ -16,6 +16,14 @@ Workspace::Workspace(Output *output, const uint32_t num)
     : num(num), output(output) {
     wl_list_init(&toplevels);
 
+    // scene subtrees stay disabled until the workspace is focused, they are
+    // destroyed along with the scene
+    Server *server = output->server;
+    layers.floating = wlr_scene_tree_create(server->layers.floating);
+    layers.fullscreen = wlr_scene_tree_create(server->layers.fullscreen);
+    wlr_scene_node_set_enabled(&layers.floating->node, false);
+    wlr_scene_node_set_enabled(&layers.fullscreen->node, false);
+
     auto_tile = output->server->config->tiling.auto_tile;
 
     // create BSP tree for BSP, grid, and dwindle tiling methods
@@ -27,12 +35,6 @@ Workspace::Workspace(Output *output, const uint32_t num)
 }
 
 Workspace::~Workspace() {
-    if (pending_layout_idle && output && output->server &&
-        output->server->display) {
-        wl_event_source_remove(pending_layout_idle);
-        pending_layout_idle = nullptr;
-    }
-
     Toplevel *toplevel, *tmp;
     wl_list_for_each_safe(toplevel, tmp, &toplevels, link) delete toplevel;
 
@@ -47,6 +49,14 @@ void Workspace::add_toplevel(Toplevel *toplevel, const bool focus) {
 
     // add to toplevels list
     wl_list_insert(&toplevels, &toplevel->link);
+    toplevel->workspace = this;
+
+    // move the scene node into this workspace
+    wlr_scene_node_reparent(&toplevel->scene_tree->node, toplevel->layer_tree());
+    schedule_visibility();
+    geometry_changed();
+    if (output)
+        output->server->cursor->invalidate_hit();
 
     // set active
     active_toplevel = toplevel;
@@ -84,12 +94,6 @@ void Workspace::add_toplevel(Toplevel *toplevel, const bool focus) {
     if (auto_tile && !toplevel->is_floating &&
         !toplevel->fullscreen() && !toplevel->maximized() &&
         !(toplevel->geometry.width <= 1 && toplevel->geometry.height <= 1)) {
-        // cancel any pending layout operations before modifying tree
-        if (pending_layout_idle) {
-            wl_event_source_remove(pending_layout_idle);
-            pending_layout_idle = nullptr;
-        }
-
         // manually unmaximize any maximized toplevels before tree operations
         // to avoid them trying to insert themselves into the tree
         Toplevel *existing_tl, *existing_tmp;
@@ -130,29 +134,23 @@ void Workspace::add_toplevel(Toplevel *toplevel, const bool focus) {
                 // BSP mode - insert at active position
                 bsp_tree->insert_at(toplevel, active_toplevel);
             }
+        }
 
-            wlr_box new_geometry;
-            if (bsp_tree->get_toplevel_geometry(toplevel, output->usable_area,
-                                                new_geometry))
-                toplevel->set_position_size(new_geometry);
-
-            // apply layout synchronously to avoid race conditions
-            bsp_tree->apply_layout(output->usable_area);
-        } else
-            tile();
+        // the new toplevel is placed with the rest of the workspace in the
+        // next layout pass
+        schedule_layout();
     }
 }
 
 Toplevel *Workspace::get_topmost_toplevel(Toplevel *sans) const {
-    wlr_scene_tree *floating_layer = output->server->layers.floating;
     wlr_scene_node *node;
-    wl_list_for_each_reverse(node, &floating_layer->children, link) {
+    wl_list_for_each_reverse(node, &layers.floating->children, link) {
         if (!node->data)
             continue;
 
         Toplevel *toplevel = static_cast<Toplevel *>(node->data);
 
-        if (sans == toplevel || !contains(toplevel))
+        if (sans == toplevel)
             continue;
 
         return toplevel;
@@ -184,6 +182,7 @@ void Workspace::close(Toplevel *toplevel) {
 
     // send close
     toplevel->close();
+    schedule_visibility();
 
     // remove from BSP tree if using it
     if (auto_tile && bsp_tree) {
@@ -205,33 +204,9 @@ void Workspace::close(Toplevel *toplevel) {
             bsp_tree->remove(toplevel);
         }
 
-        if (pending_layout_idle) {
-            wl_event_source_remove(pending_layout_idle);
-        }
-        pending_layout_idle = wl_event_loop_add_idle(
-            wl_display_get_event_loop(output->server->display),
-            [](void *data) {
-                Workspace *workspace = static_cast<Workspace *>(data);
-                workspace->pending_layout_idle = nullptr;
-                if (workspace->bsp_tree)
-                    workspace->bsp_tree->apply_layout(
-                        workspace->output->usable_area);
-                else
-                    workspace->tile();
-            },
-            this);
-    } else if (auto_tile) {
-        if (pending_layout_idle)
-            wl_event_source_remove(pending_layout_idle);
-        pending_layout_idle = wl_event_loop_add_idle(
-            wl_display_get_event_loop(output->server->display),
-            [](void *data) {
-                Workspace *workspace = static_cast<Workspace *>(data);
-                workspace->pending_layout_idle = nullptr;
-                workspace->tile();
-            },
-            this);
-    }
+        schedule_layout();
+    } else if (auto_tile)
+        schedule_layout();
 }
 
 // close the active toplevel
@@ -239,17 +214,7 @@ void Workspace::close_active() { close(active_toplevel); }
 
 // returns true if the workspace contains the passed toplevel
 bool Workspace::contains(const Toplevel *toplevel) const {
-    // no toplevels
-    if (wl_list_empty(&toplevels))
-        return false;
-
-    // check if toplevel is in workspace
-    Toplevel *current, *tmp;
-    wl_list_for_each_safe(current, tmp, &toplevels,
-                          link) if (current == toplevel) return true;
-
-    // toplevel not found
-    return false;
+    return toplevel && toplevel->workspace == this;
 }
 
 // move a toplevel to another workspace, returns true on success
@@ -259,10 +224,6 @@ bool Workspace::move_to(Toplevel *toplevel, Workspace *workspace) {
     if (workspace == this || !contains(toplevel))
         return false;
 
-    // only hide toplevel if moving to a workspace on the same output
-    if (output == output->server->focused_output())
-        toplevel->set_hidden(true);
-
     // update active_toplevel if necessary
     if (toplevel == active_toplevel) {
         if (wl_list_length(&toplevels) > 1)
@@ -293,23 +254,14 @@ bool Workspace::move_to(Toplevel *toplevel, Workspace *workspace) {
             bsp_tree->remove(toplevel);
         }
 
-        if (pending_layout_idle) {
-            wl_event_source_remove(pending_layout_idle);
-        }
-        pending_layout_idle = wl_event_loop_add_idle(
-            wl_display_get_event_loop(output->server->display),
-            [](void *data) {
-                Workspace *workspace = static_cast<Workspace *>(data);
-                workspace->pending_layout_idle = nullptr;
-                if (workspace->bsp_tree)
-                    workspace->bsp_tree->apply_layout(
-                        workspace->output->usable_area);
-            },
-            this);
+        schedule_layout();
     }
 
     // move to other workspace
     wl_list_remove(&toplevel->link);
+    toplevel->workspace = nullptr;
+    schedule_visibility();
+    geometry_changed();
     workspace->add_toplevel(toplevel, true);
 
     // notify clients
@@ -320,11 +272,22 @@ bool Workspace::move_to(Toplevel *toplevel, Workspace *workspace) {
 }
 
 // set the workspace visibility
-void Workspace::set_hidden(const bool hidden) const {
-    Toplevel *toplevel, *tmp;
-    wl_list_for_each_safe(toplevel, tmp, &toplevels, link)
-        // set every toplevel to the value of hidden
-        toplevel->set_hidden(hidden);
+void Workspace::set_hidden(const bool hidden) {
+    if (this->hidden == hidden)
+        return;
+
+    this->hidden = hidden;
+
+    // toggle the whole subtree instead of every toplevel
+    wlr_scene_node_set_enabled(&layers.floating->node, !hidden);
+    wlr_scene_node_set_enabled(&layers.fullscreen->node, !hidden);
+    schedule_visibility();
+
+    // the surfaces under the cursor changed
+    output->server->cursor->invalidate_hit();
+
+    if (IPC *ipc = output->server->ipc)
+        ipc->notify_clients(IPC_TOPLEVEL_LIST);
 }
 
 // swap the geometry of toplevel a and b
@@ -364,10 +327,7 @@ void Workspace::swap(Toplevel *a, Toplevel *b) {
     }
 
     // cancel any pending layout operations to avoid conflicts
-    if (pending_layout_idle) {
-        wl_event_source_remove(pending_layout_idle);
-        pending_layout_idle = nullptr;
-    }
+    needs_layout = false;
 
     // Use transaction for atomic swap
     output->server->transaction_manager->begin();
@@ -382,10 +342,7 @@ void Workspace::swap(Toplevel *a, Toplevel *b) {
         BSPNode *node_a = bsp_tree->find_node(a);
         BSPNode *node_b = bsp_tree->find_node(b);
 
-        if (node_a && node_b && node_a->is_leaf() && node_b->is_leaf()) {
-            node_a->toplevel = b;
-            node_b->toplevel = a;
-
+        if (node_a && node_b && bsp_tree->swap(a, b)) {
             a->set_position_size(node_b->geometry);
             b->set_position_size(node_a->geometry);
 
@@ -411,61 +368,31 @@ void Workspace::swap(Toplevel *other) { swap(active_toplevel, other); }
 // get the toplevel relative to the active one in the specified direction
 // returns nullptr if no toplevel matches query
 Toplevel *Workspace::in_direction(const wlr_direction direction) const {
-    // no other toplevel to focus or no active toplevel
-    if (wl_list_length(&toplevels) < 2 || !active_toplevel)
+    // no active toplevel
+    if (!active_toplevel)
         return nullptr;
 
-    // get the geometry of the active toplevel
-    const wlr_box &active_geometry = active_toplevel->geometry;
-
-    // define a target
-    Toplevel *curr, *tmp;
-    int min_primary = std::numeric_limits<int>::max();
-    int min_secondary = std::numeric_limits<int>::max();
-    Toplevel *target = nullptr;
-
-    // find the smallest positive distance, absolute axis
-    auto process = [&](const int primary, const int secondary) {
-        // note the greater or equals is needed for tiled windows since they
-        // are placed perfectly on the same axis
-        if (primary > 0 && primary <= min_primary &&
-            secondary <= min_secondary) {
-            target = curr;
-            min_primary = primary;
-            min_secondary = secondary;
-        }
-    };
+    // no other toplevel to focus
+    const SpatialIndex &index = spatial();
+    if (index.left.size() < 2)
+        return nullptr;
 
-    // get the non-negative displacement for each direction,
-    // - find the smallest distance
-    // - find the smallest absolute difference in the other axis
-    switch (direction) {
-    case WLR_DIRECTION_UP:
-        wl_list_for_each_safe(curr, tmp, &toplevels, link)
-            process(active_geometry.y - curr->geometry.y,
-                    std::abs(active_geometry.x - curr->geometry.x));
-        break;
-    case WLR_DIRECTION_DOWN:
-        wl_list_for_each_safe(curr, tmp, &toplevels, link)
-            process(curr->geometry.y - active_geometry.y,
-                    std::abs(active_geometry.x - curr->geometry.x));
-        break;
-    case WLR_DIRECTION_LEFT:
-        wl_list_for_each_safe(curr, tmp, &toplevels, link)
-            process(active_geometry.x - curr->geometry.x,
-                    std::abs(active_geometry.y - curr->geometry.y));
-        break;
-    case WLR_DIRECTION_RIGHT:
-        wl_list_for_each_safe(curr, tmp, &toplevels, link)
-            process(curr->geometry.x - active_geometry.x,
-                    std::abs(active_geometry.y - curr->geometry.y));
-        break;
-    default:
-        break;
-    }
+    // find the closest edge past the active toplevel, then the smallest
+    // absolute difference in the other axis
+    return index.nearest(active_toplevel->geometry, direction);
+}
 
-    // this will be null if a toplevel is not found in the specified direction
-    return target;
+// get the spatial index, rebuilding it if geometry changed since last use
+const SpatialIndex &Workspace::spatial() const {
+    spatial_index.update(const_cast<wl_list *>(&toplevels), geometry_serial);
+    return spatial_index;
+}
+
+// a toplevel of this workspace moved, resized, came or went
+void Workspace::geometry_changed() {
+    ++geometry_serial;
+    if (output)
+        ++output->server->geometry_serial;
 }
 
 // set the toplevel to take up half the screen in the given direction
@@ -571,221 +498,86 @@ void Workspace::focus_prev() {
 // auto-tile the toplevels of a workspace, not currently reversible or
 // any kind of special state
 void Workspace::tile(std::vector<Toplevel *> sans_toplevels) {
-    // no toplevels to tile
-    if (wl_list_empty(&toplevels))
-        return;
-
-    // get the output's usable area
-    wlr_box box = output->usable_area;
-
-    int toplevel_count = wl_list_length(&toplevels);
-
-    // do not tile fullscreen, maximized, or floating toplevels
+    // do not tile fullscreen, maximized, floating or excluded toplevels
+    layout_toplevels.clear();
     Toplevel *toplevel, *tmp;
-    std::vector<Toplevel *> tiled;
     wl_list_for_each_safe(toplevel, tmp, &toplevels, link) {
         if (toplevel->fullscreen() || toplevel->maximized() ||
             toplevel->is_floating)
-            --toplevel_count;
-        else
-            tiled.push_back(toplevel);
-    }
+            continue;
 
-    // remove sans_toplevels from tiled list
-    for (Toplevel *toplevel : sans_toplevels) {
-        std::vector<Toplevel *>::iterator it =
-            std::find(tiled.begin(), tiled.end(), toplevel);
-        if (it != tiled.end()) {
-            tiled.erase(it);
-            --toplevel_count;
-        }
+        if (std::find(sans_toplevels.begin(), sans_toplevels.end(),
+                      toplevel) != sans_toplevels.end())
+            continue;
+
+        layout_toplevels.push_back(toplevel);
     }
 
     // ensure there is a toplevel to tile
-    if (!toplevel_count)
+    if (layout_toplevels.empty())
         return;
 
-    // start transaction for atomic tile updates
-    output->server->transaction_manager->begin();
-
-    // tile according to tiling method
-    switch (output->server->config->tiling.method) {
-    case TILE_GRID: {
-        // calculate rows and cols from toplevel count
-        int rows = std::round(std::sqrt(toplevel_count));
-        int cols = (toplevel_count + rows - 1) / rows;
-
-        // width and height is just the fraction of the output binds
-        int width = box.width / cols;
-        int height = box.height / rows;
-
-        // sort by row and column order
-        std::sort(tiled.begin(), tiled.end(), [&](Toplevel *a, Toplevel *b) {
-            int ar = a->geometry.y / height;
-            int ac = a->geometry.x / width;
-            int br = b->geometry.y / height;
-            int bc = b->geometry.x / width;
-
-            // if rows are equal compare columns
-            if (ar == br)
-                return ac < bc;
-
-            // otherwise compare rows
-            return ar < br;
-        });
-
-        // loop through each toplevel
-        for (int i = 0; i < toplevel_count - 1; ++i) {
-            // calculate toplevel geometry
-            int row = i / cols;
-            int col = i % cols;
-            int x = output->layout_geometry.x + box.x + (col * width);
-            int y = output->layout_geometry.y + box.y + (row * height);
-
-            // ensure decorations are shown for server-side decorations
-            if (tiled[i]->decoration &&
-                tiled[i]->decoration_mode ==
-                    WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE)
-                tiled[i]->decoration->set_visible(true);
-
-            // set toplevel geometry
-            tiled[i]->set_position_size(x, y, width, height);
+    size_t count = layout_toplevels.size();
+    TileMethod method = output->server->config->tiling.method;
+
+    // usable area in layout coordinates
+    wlr_box area = output->usable_area;
+    area.x += output->layout_geometry.x;
+    area.y += output->layout_geometry.y;
+
+    // the last result is reused if the method, area and ordered set of tiled
+    // toplevels match, fullscreen, maximized and floating toplevels are never
+    // part of that set
+    bool cached = method == layout_cache_method &&
+                  wlr_box_equal(&area, &layout_cache_area) &&
+                  layout_toplevels == layout_cache_toplevels;
+
+    // layouts are stable, toplevels still in their cached boxes stay there
+    if (cached)
+        for (size_t i = 0; cached && i != count; ++i) {
+            wlr_box current = layout_toplevels[i]->target_geometry();
+            cached = wlr_box_equal(&current, &layout_boxes[i]);
         }
 
-        // calculate last toplevel geometry
-        int i = toplevel_count - 1;
-        int row = i / cols;
-        int col = i % cols;
-        int x = output->layout_geometry.x + box.x + (col * width);
-        int y = output->layout_geometry.y + box.y + (row * height);
+    if (!cached) {
+        layout_windows.clear();
+        for (size_t i = 0; i != count; ++i)
+            layout_windows.push_back(
+                {layout_toplevels[i]->geometry, static_cast<uint32_t>(i)});
+        layout_boxes.resize(count);
 
-        // stretch width to fill remaining space
-        if (int area = cols * rows; area != toplevel_count)
-            width *= (1 + area - toplevel_count);
+        if (!layout::arrange(method, {layout_windows.data(), count}, area,
+                             {layout_boxes.data(), count}))
+            return;
 
-        // ensure decorations are shown for server-side decorations
-        if (tiled[i]->decoration &&
-            tiled[i]->decoration_mode ==
-                WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE)
-            tiled[i]->decoration->set_visible(true);
+        layout_cache_method = method;
+        layout_cache_area = area;
+        layout_cache_toplevels = layout_toplevels;
+    }
 
-        // set last toplevel geometry
-        tiled[i]->set_position_size(x, y, width, height);
+    // start transaction for atomic tile updates
+    output->server->transaction_manager->begin();
 
-        break;
-    }
-    case TILE_MASTER:
-        if (toplevel_count == 1) {
-            // ensure decorations are shown for server-side decorations
-            if (tiled[0]->decoration &&
-                tiled[0]->decoration_mode ==
-                    WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE)
-                tiled[0]->decoration->set_visible(true);
-
-            // take up full screen
-            tiled[0]->set_position_size(box.x, box.y, box.width, box.height);
-        } else {
-            // calculate slave toplevel geometry
-            int width = box.width / 2;
-            int count = toplevel_count - 1;
-            int height = box.height / count;
-
-            // find master toplevel index
-            std::vector<Toplevel *>::iterator it = tiled.begin();
-            for (std::vector<Toplevel *>::iterator i = it + 1; i < tiled.end();
-                 ++i)
-                if ((*i)->geometry.x + (*i)->geometry.y <
-                    (*it)->geometry.x + (*it)->geometry.y)
-                    it = i;
-
-            // ensure decorations are shown for server-side decorations
-            if ((*it)->decoration &&
-                (*it)->decoration_mode ==
-                    WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE)
-                (*it)->decoration->set_visible(true);
-
-            // set master toplevel geometry
-            (*it)->set_position_size(box.x, box.y, width, box.height);
-
-            // remove from list
-            tiled.erase(it);
-
-            // sort by y
-            std::sort(tiled.begin(), tiled.end(),
-                      [&](Toplevel *a, Toplevel *b) {
-                          if (a->geometry.y == b->geometry.y)
-                              return true;
-                          return a->geometry.y < b->geometry.y;
-                      });
-
-            // x position is always half of the output width
-            int x = output->layout_geometry.x + box.x + width;
-            int y = output->layout_geometry.y + box.y;
-
-            // set slave toplevel geometry
-            for (int i = 0; i != count; ++i) {
-                // ensure decorations are shown for server-side decorations
-                if (tiled[i]->decoration &&
-                    tiled[i]->decoration_mode ==
-                        WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE)
-                    tiled[i]->decoration->set_visible(true);
-
-                tiled[i]->set_position_size(x, y + i * height, width, height);
-            }
-        }
+    for (size_t i = 0; i != count; ++i) {
+        Toplevel *tl = layout_toplevels[i];
+        const wlr_box &box = layout_boxes[i];
 
-        break;
-    case TILE_DWINDLE: {
-        // start with width and height being the full output area
-        int width = box.width;
-        int height = box.height;
-        int x = output->layout_geometry.x + box.x;
-        int y = output->layout_geometry.y + box.y;
-
-        // sort by sum of x and y
-        std::sort(tiled.begin(), tiled.end(), [&](Toplevel *a, Toplevel *b) {
-            // with equal x values assume second toplevel is greater
-            if (a->geometry.x == b->geometry.x)
-                return true;
-
-            // otherwise compare sums
-            return a->geometry.x + a->geometry.y <
-                   b->geometry.x + b->geometry.y;
-        });
-
-        // 1 toplevel means that it should take up the full screen
-        if (tiled.size() != 1)
-            width /= 2;
-
-        for (int i = 0; i != toplevel_count; ++i) {
-            // ensure decorations are shown for server-side decorations
-            if (tiled[i]->decoration &&
-                tiled[i]->decoration_mode ==
-                    WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE)
-                tiled[i]->decoration->set_visible(true);
-
-            // set toplevel geometry
-            tiled[i]->set_position_size(x, y, width, height);
-
-            if (i % 2) {
-                // do not change size for last toplevel
-                if (i != toplevel_count - 2)
-                    width /= 2;
-                // add height to y
-                y += height;
-            } else {
-                // do not change size for last toplevel
-                if (i != toplevel_count - 2)
-                    height /= 2;
-                // add width to x
-                x += width;
-            }
-        }
+        // ensure decorations are shown for server-side decorations
+        bool show_decoration =
+            tl->decoration &&
+            tl->decoration_mode ==
+                WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE &&
+            !tl->decoration->visible;
+        if (show_decoration)
+            tl->decoration->set_visible(true);
+
+        // only touch toplevels whose box changed
+        wlr_box current = tl->target_geometry();
+        if (!show_decoration && !tl->scene_hidden_for_autotile &&
+            wlr_box_equal(&current, &box))
+            continue;
 
-        break;
-    }
-    default:
-        break;
+        tl->set_position_size(box);
     }
 
     // commit transaction
@@ -805,50 +597,95 @@ void Workspace::toggle_auto_tile() {
     auto_tile = !auto_tile;
 
     // set auto tile for all workspaces when toggling
-    if (auto_tile) {
-        TileMethod method = output->server->config->tiling.method;
+    if (auto_tile)
+        retile();
+    else
+        bsp_tree.reset();
+}
 
-        if (method == TILE_BSP || method == TILE_GRID ||
-            method == TILE_DWINDLE) {
-            if (!bsp_tree)
-                bsp_tree = std::make_unique<BSPTree>(this);
+// rebuild the auto tile layout with the configured tiling method
+void Workspace::retile() {
+    TileMethod method = output->server->config->tiling.method;
 
-            std::vector<Toplevel *> tls;
-            Toplevel *toplevel, *tmp;
-            wl_list_for_each_safe(
-                toplevel, tmp, &toplevels,
-                link) if (!toplevel->fullscreen() && !toplevel->maximized() &&
-                          !toplevel->is_floating) tls.push_back(toplevel);
+    if (method == TILE_BSP || method == TILE_GRID || method == TILE_DWINDLE) {
+        if (!bsp_tree)
+            bsp_tree = std::make_unique<BSPTree>(this);
 
-            if (method == TILE_GRID)
-                bsp_tree->rebuild_grid(tls);
-            else if (method == TILE_DWINDLE)
-                bsp_tree->rebuild_dwindle(tls);
-            else
-                bsp_tree->rebuild(tls);
-
-            if (pending_layout_idle)
-                wl_event_source_remove(pending_layout_idle);
-
-            pending_layout_idle = wl_event_loop_add_idle(
-                wl_display_get_event_loop(output->server->display),
-                [](void *data) {
-                    Workspace *workspace = static_cast<Workspace *>(data);
-                    workspace->pending_layout_idle = nullptr;
-                    if (workspace->bsp_tree)
-                        workspace->bsp_tree->apply_layout(
-                            workspace->output->usable_area);
-                },
-                this);
-        } else {
-            bsp_tree.reset();
-            tile();
+        std::vector<Toplevel *> tls;
+        Toplevel *toplevel, *tmp;
+        wl_list_for_each_safe(toplevel, tmp, &toplevels, link) {
+            if (!toplevel->fullscreen() && !toplevel->maximized() &&
+                !toplevel->is_floating)
+                tls.push_back(toplevel);
         }
+
+        if (method == TILE_GRID)
+            bsp_tree->rebuild_grid(tls);
+        else if (method == TILE_DWINDLE)
+            bsp_tree->rebuild_dwindle(tls);
+        else
+            bsp_tree->rebuild(tls);
+
+        schedule_layout();
     } else {
         bsp_tree.reset();
+        tile();
     }
 }
 
+// flag the workspace for a layout pass once the event loop is idle, an
+// orphaned workspace keeps the flag until its output returns
+void Workspace::schedule_layout() {
+    needs_layout = true;
+    if (!output)
+        return;
+
+    output->server->workspace_manager->schedule_idle();
+}
+
+// flag the workspace for a visibility update once the event loop is idle
+void Workspace::schedule_visibility() {
+    needs_visibility = true;
+    if (!output)
+        return;
+
+    output->server->workspace_manager->schedule_idle();
+}
+
+// suspend toplevels that cannot be seen, either because the workspace is
+// hidden, they are waiting to be tiled, or a fullscreen toplevel covers them
+void Workspace::update_visibility() {
+    needs_visibility = false;
+
+    // the topmost fullscreen toplevel covers the whole output
+    Toplevel *cover = nullptr;
+    wlr_scene_node *node;
+    wl_list_for_each_reverse(node, &layers.fullscreen->children, link) {
+        if (node->enabled && node->data) {
+            cover = static_cast<Toplevel *>(node->data);
+            break;
+        }
+    }
+
+    Toplevel *toplevel, *tmp;
+    wl_list_for_each_safe(toplevel, tmp, &toplevels, link)
+        toplevel->set_suspended(hidden || toplevel->scene_hidden_for_autotile ||
+                                (cover && toplevel != cover));
+}
+
+// run a deferred layout pass
+void Workspace::layout() {
+    needs_layout = false;
+
+    if (!auto_tile)
+        return;
+
+    if (bsp_tree)
+        bsp_tree->apply_layout(output->usable_area);
+    else
+        tile();
+}
+
 // Adjust neighboring toplevels when one is resized in auto-tile mode
 void Workspace::adjust_neighbors_on_resize(Toplevel *resized,
                                            const wlr_box &old_geo) {
@@ -857,19 +694,7 @@ void Workspace::adjust_neighbors_on_resize(Toplevel *resized,
 
     if (bsp_tree) {
         bsp_tree->handle_resize(resized, old_geo);
-        if (pending_layout_idle) {
-            wl_event_source_remove(pending_layout_idle);
-        }
-        pending_layout_idle = wl_event_loop_add_idle(
-            wl_display_get_event_loop(output->server->display),
-            [](void *data) {
-                Workspace *workspace = static_cast<Workspace *>(data);
-                workspace->pending_layout_idle = nullptr;
-                if (workspace->bsp_tree)
-                    workspace->bsp_tree->apply_layout(
-                        workspace->output->usable_area);
-            },
-            this);
+        schedule_layout();
         return;
     }
 
@@ -881,16 +706,19 @@ void Workspace::adjust_neighbors_on_resize(Toplevel *resized,
     int bottom_delta =
         (new_geo.y + new_geo.height) - (old_geo.y + old_geo.height);
 
-    Toplevel *toplevel, *tmp;
-    wl_list_for_each_safe(toplevel, tmp, &toplevels, link) {
+    const int ADJACENT_THRESHOLD = 35;
+
+    // only toplevels with an edge near one of the old edges can be affected
+    std::vector<Toplevel *> neighbors;
+    spatial().adjacent(old_geo, ADJACENT_THRESHOLD, neighbors);
+
+    for (Toplevel *toplevel : neighbors) {
         if (toplevel == resized || toplevel->fullscreen())
             continue;
 
         wlr_box geo = toplevel->geometry;
         bool modified = false;
 
-        const int ADJACENT_THRESHOLD = 35;
-
         // right
         if (right_delta != 0 && std::abs(geo.x - (old_geo.x + old_geo.width)) <
                                     ADJACENT_THRESHOLD) {
@@ -1,12 +1,17 @@
 #include "WorkspaceManager.h"
 #include "IPC.h"
 #include "Server.h"
+#include "Toplevel.h"
+#include "Transaction.h"
 
 WorkspaceManager::WorkspaceManager(Server *server) : server(server) {
     wl_list_init(&workspaces);
 }
 
 WorkspaceManager::~WorkspaceManager() {
+    if (pending_idle)
+        wl_event_source_remove(pending_idle);
+
     Workspace *workspace, *tmp;
     wl_list_for_each_safe(workspace, tmp, &workspaces, link) delete workspace;
 
@@ -22,20 +27,85 @@ Workspace *WorkspaceManager::new_workspace(Output *output, uint32_t num) {
     Workspace *workspace = new Workspace(output, num);
     wl_list_insert(&workspaces, &workspace->link);
 
-    // notify clients
+    // index by number
+    if (num >= output->workspaces.size())
+        output->workspaces.resize(num + 1, nullptr);
+    output->workspaces[num] = workspace;
+
+    // notify clients, creations in the same loop iteration are sent as one
     if (server->ipc)
-        server->ipc->notify_clients({IPC_OUTPUT_LIST, IPC_WORKSPACE_LIST});
+        server->ipc->notify_clients_later({IPC_OUTPUT_LIST, IPC_WORKSPACE_LIST});
 
     return workspace;
 }
 
+// get workspace by number for an output, creating it on first use
+Workspace *WorkspaceManager::ensure_workspace(uint32_t num, Output *output) {
+    if (!output || num < 1 || num > WORKSPACE_COUNT)
+        return nullptr;
+
+    if (Workspace *workspace = get_workspace(num, output))
+        return workspace;
+
+    return new_workspace(output, num);
+}
+
+// run deferred layouts and visibility updates once the current event loop
+// iteration is done
+void WorkspaceManager::schedule_idle() {
+    if (pending_idle)
+        return;
+
+    pending_idle = wl_event_loop_add_idle(
+        wl_display_get_event_loop(server->display),
+        [](void *data) {
+            WorkspaceManager *manager = static_cast<WorkspaceManager *>(data);
+            manager->pending_idle = nullptr;
+            manager->flush_layouts();
+            manager->flush_visibility();
+        },
+        this);
+}
+
+// lay out every flagged workspace in a single transaction
+void WorkspaceManager::flush_layouts() {
+    TransactionManager *transactions = server->transaction_manager;
+    bool started = false;
+
+    Workspace *workspace, *tmp;
+    wl_list_for_each_safe(workspace, tmp, &workspaces, link) {
+        if (!workspace->needs_layout)
+            continue;
+
+        if (!started) {
+            transactions->begin();
+            started = true;
+        }
+
+        workspace->layout();
+    }
+
+    if (started)
+        transactions->commit();
+}
+
+// update the suspended state of toplevels on every flagged workspace
+void WorkspaceManager::flush_visibility() {
+    Workspace *workspace, *tmp;
+    wl_list_for_each_safe(workspace, tmp, &workspaces, link)
+        if (workspace->needs_visibility)
+            workspace->update_visibility();
+}
+
 // get workspace by number, optionally filtering by output
 Workspace *WorkspaceManager::get_workspace(uint32_t num, Output *output) const {
+    if (output)
+        return num < output->workspaces.size() ? output->workspaces[num]
+                                               : nullptr;
+
     Workspace *workspace, *tmp;
-    wl_list_for_each_safe(
-        workspace, tmp, &workspaces,
-        link) if (workspace->num == num &&
-                  (!output || workspace->output == output)) return workspace;
+    wl_list_for_each_safe(workspace, tmp, &workspaces,
+                          link) if (workspace->num == num) return workspace;
     return nullptr;
 }
 
@@ -44,12 +114,7 @@ Workspace *WorkspaceManager::get_active_workspace(Output *output) const {
     if (!output)
         return nullptr;
 
-    // find first workspace of output
-    Workspace *workspace, *tmp;
-    wl_list_for_each_safe(workspace, tmp, &workspaces,
-                          link) if (workspace->output ==
-                                    output) return workspace;
-    return nullptr;
+    return get_workspace(output->active_workspace, output);
 }
 
 // set the active workspace
@@ -60,23 +125,21 @@ bool WorkspaceManager::set_workspace(Workspace *workspace) {
     Output *output = workspace->output;
     Workspace *previous = get_active_workspace(output);
 
-    // invalid workspace
-    if (!previous)
-        return false;
-
     // workspace is already active
     if (workspace == previous)
         return true;
 
-    // hide workspace we are moving from
-    previous->set_hidden(true);
+    // hide workspace we are moving from, a new output has none
+    std::vector<Toplevel *> pinned;
+    if (previous) {
+        previous->set_hidden(true);
 
-    // get pinned toplevels from previous workspace
-    std::vector<Toplevel *> pinned = previous->pinned();
+        // get pinned toplevels from previous workspace
+        pinned = previous->pinned();
+    }
 
     // set workspace to active
-    wl_list_remove(&workspace->link);
-    wl_list_insert(&workspaces, &workspace->link);
+    output->active_workspace = workspace->num;
 
     // move pinned toplevels to new workspace
     for (Toplevel *toplevel : pinned)
@@ -90,7 +153,7 @@ bool WorkspaceManager::set_workspace(Workspace *workspace) {
 
 // set active workspace by number for an output
 bool WorkspaceManager::set_workspace(uint32_t num, Output *output) {
-    return set_workspace(get_workspace(num, output));
+    return set_workspace(ensure_workspace(num, output));
 }
 
 // find workspace containing given toplevel
@@ -99,11 +162,9 @@ WorkspaceManager::get_workspace_for_toplevel(Toplevel *toplevel) const {
     if (!toplevel)
         return nullptr;
 
-    Workspace *workspace, *tmp;
-    wl_list_for_each_safe(
-        workspace, tmp, &workspaces,
-        link) if (workspace->contains(toplevel)) return workspace;
-    return nullptr;
+    // workspaces of a removed output are not reachable
+    Workspace *workspace = toplevel->workspace;
+    return workspace && workspace->output ? workspace : nullptr;
 }
 
 // turn all workspaces into orphans
@@ -115,13 +176,15 @@ void WorkspaceManager::orphanize_workspaces(Output *output) {
     uint32_t active_num = active_workspace->num;
     std::vector<Workspace *> orphans;
 
-    Workspace *ws, *tmp;
-    wl_list_for_each_safe(ws, tmp, &workspaces,
-                          link) if (ws->output == output) {
+    for (Workspace *ws : output->workspaces) {
+        if (!ws)
+            continue;
+
         ws->output = nullptr;
         orphans.push_back(ws);
         wl_list_remove(&ws->link);
     }
+    output->workspaces.clear();
 
     orphaned_outputs_map[output->wlr_output->name] =
         OrphanedOutput{active_num, orphans};
@@ -141,9 +204,22 @@ bool WorkspaceManager::adopt_workspaces(Output *output) {
     for (Workspace *workspace : orphaned.workspaces) {
         workspace->output = output;
         wl_list_insert(&workspaces, &workspace->link);
+
+        if (workspace->num >= output->workspaces.size())
+            output->workspaces.resize(workspace->num + 1, nullptr);
+        output->workspaces[workspace->num] = workspace;
+
+        // run what was flagged while the workspace had no output
+        workspace->schedule_visibility();
+        if (workspace->needs_layout)
+            workspace->schedule_layout();
     }
 
-    set_workspace(orphaned.active_num, output);
+    // restore the workspace that was active when the output went away
+    output->active_workspace = orphaned.active_num;
+    if (Workspace *active = get_active_workspace(output))
+        active->focus();
+
     orphaned_outputs_map.erase(it);
     return true;
 }
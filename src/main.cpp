@@ -172,6 +172,9 @@ int main(const int argc, char *argv[]) {
 
     // start server
     Server *server = new Server(config);
+
+    // reloads replace the config the server started with
+    config = server->config;
     delete server;
     delete config;
 }